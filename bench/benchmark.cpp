@@ -1,14 +1,169 @@
 #include "units_core.h"
+#include "units_ensemble.h"
+#include "units_trace.h"
 #include <iostream>
 #include <random>
 #include <chrono>
 #include <string>
 #include <cstring>
+#include <algorithm>
+#include <vector>
+#include <type_traits>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <atomic>
+#include <new>
+#include <thread>
 
 #ifdef _OPENMP
 #include <omp.h>
 #endif
 
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+// Heap allocation counter: the global operator new is replaced so that the benchmark can
+// report how many allocations the timed steps made (steady-state stepping should make none).
+// Every replacement goes through the two helpers below, which pair malloc / aligned_alloc with
+// free; they are kept out of line so that GCC does not see free() applied to the result of an
+// inlined operator new (-Wmismatched-new-delete).
+static std::atomic<std::size_t> g_heap_allocations{0};
+
+__attribute__((noinline)) static void* counted_allocate(std::size_t size, std::size_t align) {
+    g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) size = 1;
+    void* p = align <= alignof(std::max_align_t)
+        ? std::malloc(size)
+        : std::aligned_alloc(align, (size + align - 1) / align * align);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+__attribute__((noinline)) static void counted_free(void* p) noexcept { std::free(p); }
+
+void* operator new(std::size_t size) { return counted_allocate(size, 0); }
+void operator delete(void* p) noexcept { counted_free(p); }
+void operator delete(void* p, std::size_t) noexcept { counted_free(p); }
+
+// Over-aligned allocations (the engine's 64-byte aligned buffers below the huge-page size)
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return counted_allocate(size, static_cast<std::size_t>(alignment));
+}
+void operator delete(void* p, std::align_val_t) noexcept { counted_free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { counted_free(p); }
+
+// Hardware counters around the timed loop (--perf-counters), via perf_event_open.
+// The counters are opened in main() before the first OpenMP region or pool thread exists, with
+// inherit set, so the worker threads created later are counted too. Each event is opened on
+// its own, so hosts that expose only some of them (VMs, containers, perf_event_paranoid)
+// still report those; counts are scaled when the kernel multiplexed them.
+class PerfCounters {
+public:
+    enum Event { Cycles, Instructions, LlcMisses, DtlbMisses, kEventCount };
+
+    PerfCounters() { std::fill(m_fd, m_fd + kEventCount, -1); }
+    ~PerfCounters()
+    {
+#if defined(__linux__)
+        for (int fd : m_fd) {
+            if (fd >= 0) close(fd);
+        }
+#endif
+    }
+
+    // Opens every event, disabled; returns false (see error()) when none is available
+    bool open()
+    {
+#if defined(__linux__)
+        const std::uint64_t dtlb_read_miss = PERF_COUNT_HW_CACHE_DTLB |
+            (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        const struct { std::uint32_t type; std::uint64_t config; } events[kEventCount] = {
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES }, // last-level cache on x86
+            { PERF_TYPE_HW_CACHE, dtlb_read_miss },
+        };
+        bool any = false;
+        for (int e = 0; e < kEventCount; ++e) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = events[e].type;
+            attr.config = events[e].config;
+            attr.disabled = 1;
+            attr.inherit = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            m_fd[e] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if (m_fd[e] >= 0) any = true;
+            else if (m_error.empty()) m_error = std::string(name(static_cast<Event>(e))) + ": " + std::strerror(errno);
+        }
+        return any;
+#else
+        m_error = "perf_event_open is Linux only";
+        return false;
+#endif
+    }
+
+    void start()
+    {
+#if defined(__linux__)
+        for (int fd : m_fd) {
+            if (fd < 0) continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    // Disables the counters and reads them (summed over the inherited threads)
+    void stop()
+    {
+#if defined(__linux__)
+        for (int e = 0; e < kEventCount; ++e) {
+            if (m_fd[e] < 0) continue;
+            ioctl(m_fd[e], PERF_EVENT_IOC_DISABLE, 0);
+            std::uint64_t data[3] = { 0, 0, 0 }; // value, time enabled, time running
+            if (read(m_fd[e], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) || data[2] == 0) {
+                m_value[e] = -1.0;
+                continue;
+            }
+            m_value[e] = static_cast<double>(data[0]) * static_cast<double>(data[1]) / static_cast<double>(data[2]);
+        }
+#endif
+    }
+
+    bool has(Event e) const { return m_fd[e] >= 0 && m_value[e] >= 0.0; }
+    double value(Event e) const { return m_value[e]; }
+    const std::string& error() const { return m_error; }
+
+    static const char* name(Event e)
+    {
+        switch (e) {
+        case Cycles: return "cycles";
+        case Instructions: return "instructions";
+        case LlcMisses: return "llc_misses";
+        case DtlbMisses: return "dtlb_misses";
+        default: return "unknown";
+        }
+    }
+
+private:
+    int m_fd[kEventCount];
+    double m_value[kEventCount] = {};
+    std::string m_error;
+};
+
+static PerfCounters g_perf_counters;
+
 // Simple CLI argument parser
 struct BenchConfig {
     int width = 128;
@@ -16,8 +171,46 @@ struct BenchConfig {
     int steps = 500;
     int warmup = 5;
     unsigned int seed = 12345;
+    bool stencil = false;
+    bool fused = false;
+    int steps_per_pass = 1;
+    std::string strategy; // empty = build default, "auto" = autotune
+    std::string precision = std::is_same<units_real, float>::value ? "float" : "double";
+    bool reference = true; // compare against a double run (precisions other than double)
+    bool until = false;    // stop early once max |delta| <= epsilon (step_until)
+    double epsilon = 0.0;
+    double active_threshold = 0.0; // > 0: active-set stepping (step() only)
+    int tile_size = 32;
+    std::string init = "random";   // random, center or edges
+    int ensemble = 0;              // > 0: step this many grids as one UnitsEnsembleT
+    int thread_pool = 0;           // > 0: step on a persistent UnitsThreadPool of this size
+    bool pin = false;              // pin OpenMP threads to CPUs before the grid is allocated
+    bool numa_report = false;      // report the state buffers' pages per NUMA node
+    std::string huge_pages = "off"; // off, thp or explicit (buffers >= 2 MB)
+    bool perf_counters = false;    // hardware counters around the timed loop
+    bool roofline = false;         // measure STREAM triad bandwidth and report percent of it
+    int stream_mb = 0;             // triad array size in MB (0 = 4x the last-level cache)
+    bool sweep = false;            // run every sizes x threads x strategies combination
+    std::string sizes;             // sweep: comma-separated N or WxH (default: --width x --height)
+    std::string threads;           // sweep: comma-separated OpenMP thread counts (default: current)
+    std::string strategies;        // sweep: comma-separated push strategies (default: all available)
+    int repeats = 5;               // sweep: fresh grids per configuration
+    bool latency = false;          // time every step into a latency histogram
+    double frame_budget_ms = 0.0;  // > 0: one step per frame of this length, count deadline misses
+    std::string trace;             // Chrome trace-event JSON written here at exit (USE_TRACE builds)
 };
 
+std::vector<std::string> split_list(const std::string& list) {
+    std::vector<std::string> items;
+    std::size_t begin = 0;
+    while (begin <= list.size()) {
+        const std::size_t end = std::min(list.find(',', begin), list.size());
+        if (end > begin) items.push_back(list.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return items;
+}
+
 BenchConfig parse_args(int argc, char** argv) {
     BenchConfig cfg;
     for (int i = 1; i < argc; ++i) {
@@ -32,6 +225,60 @@ BenchConfig parse_args(int argc, char** argv) {
             cfg.warmup = std::stoi(argv[++i]);
         } else if (arg == "--seed" && i + 1 < argc) {
             cfg.seed = static_cast<unsigned int>(std::stoul(argv[++i]));
+        } else if (arg == "--stencil") {
+            cfg.stencil = true;
+        } else if (arg == "--fused") {
+            cfg.fused = true;
+        } else if (arg == "--steps-per-pass" && i + 1 < argc) {
+            cfg.steps_per_pass = std::stoi(argv[++i]);
+        } else if (arg == "--strategy" && i + 1 < argc) {
+            cfg.strategy = argv[++i];
+        } else if (arg == "--precision" && i + 1 < argc) {
+            cfg.precision = argv[++i];
+        } else if (arg == "--until" && i + 1 < argc) {
+            cfg.until = true;
+            cfg.epsilon = std::stod(argv[++i]);
+        } else if (arg == "--active-set" && i + 1 < argc) {
+            cfg.active_threshold = std::stod(argv[++i]);
+        } else if (arg == "--tile-size" && i + 1 < argc) {
+            cfg.tile_size = std::stoi(argv[++i]);
+        } else if (arg == "--init" && i + 1 < argc) {
+            cfg.init = argv[++i];
+        } else if (arg == "--ensemble" && i + 1 < argc) {
+            cfg.ensemble = std::stoi(argv[++i]);
+        } else if (arg == "--thread-pool" && i + 1 < argc) {
+            cfg.thread_pool = std::stoi(argv[++i]);
+        } else if (arg == "--pin") {
+            cfg.pin = true;
+        } else if (arg == "--numa-report") {
+            cfg.numa_report = true;
+        } else if (arg == "--huge-pages" && i + 1 < argc) {
+            cfg.huge_pages = argv[++i];
+        } else if (arg == "--perf-counters") {
+            cfg.perf_counters = true;
+        } else if (arg == "--roofline") {
+            cfg.roofline = true;
+        } else if (arg == "--stream-mb" && i + 1 < argc) {
+            cfg.stream_mb = std::stoi(argv[++i]);
+        } else if (arg == "--sweep") {
+            cfg.sweep = true;
+        } else if (arg == "--sizes" && i + 1 < argc) {
+            cfg.sizes = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            cfg.threads = argv[++i];
+        } else if (arg == "--strategies" && i + 1 < argc) {
+            cfg.strategies = argv[++i];
+        } else if (arg == "--repeats" && i + 1 < argc) {
+            cfg.repeats = std::stoi(argv[++i]);
+        } else if (arg == "--latency") {
+            cfg.latency = true;
+        } else if (arg == "--frame-budget" && i + 1 < argc) {
+            cfg.latency = true;
+            cfg.frame_budget_ms = std::stod(argv[++i]);
+        } else if (arg == "--trace" && i + 1 < argc) {
+            cfg.trace = argv[++i];
+        } else if (arg == "--no-reference") {
+            cfg.reference = false;
         } else if (arg == "--help") {
             std::cout << "Usage: bench_units [options]\n"
                       << "  --width <W>      Grid width (default: 128)\n"
@@ -39,55 +286,411 @@ BenchConfig parse_args(int argc, char** argv) {
                       << "  --steps <S>      Number of simulation steps (default: 500)\n"
                       << "  --warmup <N>     Number of warmup steps (default: 5)\n"
                       << "  --seed <S>       Random seed (default: 12345)\n"
+                      << "  --stencil        Compute neighbor offsets arithmetically (no CSR arrays)\n"
+                      << "  --fused          Use the single-pass step_fused() instead of step()\n"
+                      << "  --steps-per-pass <K>  Advance K steps per sweep with step_n() (default: 1)\n"
+                      << "  --strategy <S>   Push strategy: atomic, per_thread_accum, halo, gather, or auto\n"
+                      << "                   (auto times each one and keeps the fastest)\n"
+                      << "  --precision <P>  Storage type: double, float, half or bfloat16\n"
+                      << "                   (default: build's USE_FLOAT; 16-bit types compute in float)\n"
+                      << "  --no-reference   Skip the error report against a double-precision run\n"
+                      << "  --until <EPS>    Run step_until(EPS, steps): stop once max |delta| <= EPS\n"
+                      << "  --active-set <T> Active-set stepping: only step tiles with |delta| > T\n"
+                      << "  --tile-size <N>  Active-set tile edge in cells (default: 32)\n"
+                      << "  --init <I>       Initial grid: random, center (one stimulus) or edges (default: random)\n"
+                      << "  --ensemble <K>   Step K grids (seeds seed..seed+K-1) interleaved in one UnitsEnsemble\n"
+                      << "  --thread-pool <N>  Step on N persistent pinned threads (one job per timed run)\n"
+                      << "  --pin            Pin OpenMP threads to CPUs (before first touch of the grid)\n"
+                      << "  --numa-report    Report the grid's pages per NUMA node\n"
+                      << "  --huge-pages <M> Back buffers >= 2 MB with huge pages: off, thp (madvise) or\n"
+                      << "                   explicit (MAP_HUGETLB, falls back to thp) (default: off)\n"
+                      << "  --perf-counters  Count cycles, instructions, LLC and dTLB misses of the timed\n"
+                      << "                   steps (Linux perf_event_open; null where unavailable)\n"
+                      << "  --roofline       Measure STREAM triad bandwidth and report the steps' share of it\n"
+                      << "  --stream-mb <MB> Triad array size (default: 4x last-level cache, 64-512 MB)\n"
+                      << "  --sweep          Time every combination of --sizes, --threads and --strategies,\n"
+                      << "                   --repeats times each, and print one JSON document of per-step\n"
+                      << "                   latency statistics (median, min, mean, stddev, p95)\n"
+                      << "  --sizes <L>      Sweep grid sizes, e.g. 128,512x256,1024 (default: width x height)\n"
+                      << "  --threads <L>    Sweep OpenMP thread counts, e.g. 1,2,4 (default: current)\n"
+                      << "  --strategies <L> Sweep push strategies (default: every available one)\n"
+                      << "  --repeats <N>    Sweep: fresh grids per configuration (default: 5)\n"
+                      << "  --latency        Time every step: p50/p90/p99/p99.9/max step latency\n"
+                      << "  --frame-budget <MS>  Like --latency, but start one step per MS-millisecond frame\n"
+                      << "                   (sleeping in between) and count steps that miss their frame\n"
+                      << "  --trace <FILE>   Write a Chrome trace of every thread's step phases to FILE at\n"
+                      << "                   exit (needs a USE_TRACE build; open in Perfetto)\n"
                       << "  --help           Show this help\n"
                       << "\n"
                       << "Build-time options (set via CMake):\n"
-                      << "  USE_FLOAT        Use float instead of double\n"
+                      << "  USE_FLOAT        Default to float instead of double\n"
                       << "  USE_OPENMP       Enable OpenMP parallelization\n"
-                      << "  USE_PER_THREAD_ACCUM  Use per-thread accumulators\n";
+                      << "  USE_PER_THREAD_ACCUM  Default to per-thread accumulators\n"
+                      << "  USE_HALO_PUSH    Default to halo-partitioned row-band push\n"
+                      << "  USE_SIMD         Explicit AVX2/AVX-512 kernels (UNITS_SIMD=scalar|avx2 to force)\n"
+                      << "  USE_STATS        Per-phase timings and traffic in the JSON line\n"
+                      << "  USE_TRACE        Per-thread phase tracing for --trace\n";
             std::exit(0);
         }
     }
     return cfg;
 }
 
-int main(int argc, char** argv) {
-    BenchConfig cfg = parse_args(argc, argv);
+// Initial values, drawn in double so that every precision starts from the same grid.
+// center / edges are the realtime viewer's mostly quiescent scenarios.
+std::vector<double> initial_values(const BenchConfig& cfg) {
+    const std::size_t N = static_cast<std::size_t>(cfg.width) * static_cast<std::size_t>(cfg.height);
+    std::vector<double> values(N, 0.0);
+    if (cfg.init == "center") {
+        values[static_cast<std::size_t>(cfg.height / 2) * cfg.width + cfg.width / 2] = 1.0;
+    } else if (cfg.init == "edges") {
+        for (int x = 0; x < cfg.width; ++x) {
+            values[x] = 1.0;
+            values[static_cast<std::size_t>(cfg.height - 1) * cfg.width + x] = 1.0;
+        }
+        for (int y = 0; y < cfg.height; ++y) {
+            values[static_cast<std::size_t>(y) * cfg.width] = 1.0;
+            values[static_cast<std::size_t>(y) * cfg.width + cfg.width - 1] = 1.0;
+        }
+    } else {
+        std::mt19937 rng(cfg.seed);
+        std::uniform_real_distribution<double> dist(-1.0, 1.0);
+        for (std::size_t i = 0; i < N; ++i) {
+            values[i] = dist(rng);
+        }
+    }
+    return values;
+}
 
-    // Validate inputs
-    if (cfg.width <= 0 || cfg.height <= 0 || cfg.steps <= 0) {
-        std::cerr << "Error: width, height, and steps must be positive\n";
-        return 1;
+// "perf" JSON field: raw counts plus IPC, misses per cell-step and the DRAM traffic the LLC
+// misses imply (one 64-byte line each). Counters the host does not provide are null.
+void print_perf_counters(const BenchConfig& cfg, double cell_steps) {
+    if (!cfg.perf_counters) return;
+    const PerfCounters& pc = g_perf_counters;
+    auto field = [&pc](PerfCounters::Event e, double scale) {
+        if (pc.has(e)) std::cout << pc.value(e) * scale;
+        else std::cout << "null";
+    };
+    std::cout << ", \"perf\": {";
+    for (int e = 0; e < PerfCounters::kEventCount; ++e) {
+        std::cout << (e ? ", " : "") << "\"" << PerfCounters::name(static_cast<PerfCounters::Event>(e)) << "\": ";
+        field(static_cast<PerfCounters::Event>(e), 1.0);
+    }
+    std::cout << ", \"ipc\": ";
+    if (pc.has(PerfCounters::Cycles) && pc.has(PerfCounters::Instructions) && pc.value(PerfCounters::Cycles) > 0) {
+        std::cout << pc.value(PerfCounters::Instructions) / pc.value(PerfCounters::Cycles);
+    } else {
+        std::cout << "null";
+    }
+    std::cout << ", \"llc_misses_per_cell_step\": ";
+    field(PerfCounters::LlcMisses, 1.0 / cell_steps);
+    std::cout << ", \"dtlb_misses_per_cell_step\": ";
+    field(PerfCounters::DtlbMisses, 1.0 / cell_steps);
+    std::cout << ", \"dram_bytes_per_cell_step\": ";
+    field(PerfCounters::LlcMisses, 64.0 / cell_steps);
+    std::cout << "}";
+}
+
+// Last-level cache size in bytes; 0 when the system does not report it
+std::size_t last_level_cache_bytes() {
+    long llc = 0;
+#if defined(_SC_LEVEL3_CACHE_SIZE)
+    llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+    return static_cast<std::size_t>(std::max(llc, 0L));
+}
+
+// STREAM triad a[i] = b[i] + s * c[i] over arrays of bytes_per_array bytes, with the stepping
+// loops' threads and static partition, best of 5, in GB/s. Counts 24 bytes per element like
+// STREAM (no write-allocate traffic), the same convention as the step traffic models below.
+// Small arrays repeat the triad within a timing (at least ~256 MB moved) so that
+// cache-resident sizes are not dominated by fork/join.
+double stream_triad_gb_per_s(std::size_t bytes_per_array) {
+    const std::size_t n = std::max<std::size_t>(bytes_per_array / sizeof(double), 1024);
+    const int passes = static_cast<int>(std::max<std::size_t>(1, (std::size_t(256) << 20) / (3 * sizeof(double) * n)));
+    units_vector<double> a, b, c;
+    units_first_touch(a, n, 0.0);
+    units_first_touch(b, n, 1.0);
+    units_first_touch(c, n, 2.0);
+    double* pa = a.data();
+    const double* pb = b.data();
+    const double* pc = c.data();
+    const double scalar = 3.0;
+    const std::ptrdiff_t count = static_cast<std::ptrdiff_t>(n);
+
+    double best = 0.0;
+    for (int rep = 0; rep < 5; ++rep) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int pass = 0; pass < passes; ++pass) {
+#ifdef _OPENMP
+            #pragma omp parallel for schedule(static)
+#endif
+            for (std::ptrdiff_t i = 0; i < count; ++i) pa[i] = pb[i] + scalar * pc[i];
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::max(best, 3.0 * sizeof(double) * n * passes / elapsed.count() * 1e-9);
+    }
+    return best;
+}
+
+// DRAM triad peak: --stream-mb arrays, by default STREAM's rule of 4x the last-level cache
+double stream_triad_gb_per_s(const BenchConfig& cfg) {
+    std::size_t bytes = static_cast<std::size_t>(cfg.stream_mb) << 20;
+    if (bytes == 0) {
+        bytes = std::min<std::size_t>(std::max<std::size_t>(4 * last_level_cache_bytes(), 64u << 20), 512u << 20);
+    }
+    return stream_triad_gb_per_s(bytes);
+}
+
+// Bytes per cell one timed step has to move at least: every array a pass touches is streamed
+// once (neighbor re-reads hit cache), as USE_STATS counts them, without write-allocate traffic
+template <typename Real>
+double step_bytes_per_cell(const BenchConfig& cfg, const UnitsCoreT<Real>& core, int threads) {
+    using Compute = typename UnitsCoreT<Real>::compute_type;
+    const double R = sizeof(Real);
+    const double C = sizeof(Compute);
+    if (!cfg.until) {
+        if (cfg.steps_per_pass > 1) return 7 * R / cfg.steps_per_pass; // one sweep per K steps
+        if (cfg.fused) return 7 * R;
+        if (core.thread_pool()) return 8 * R; // integrate, then a second pass to gather
+    }
+    // update() reads 4 arrays and writes 3; push() reads the deltas and updates delta_steps.
+    // The scatter strategies also read the CSR lists (8 neighbors + offset per cell).
+    const double update = 7 * R;
+    const double csr = core.neighbor_mode() == UnitsNeighborMode::Explicit ? 9.0 * sizeof(int) : 0.0;
+    switch (core.push_strategy()) {
+    case UnitsPushStrategy::Gather: return update + 3 * R;
+    case UnitsPushStrategy::HaloPartitioned: return update + 3 * R + csr;
+    case UnitsPushStrategy::PerThreadAccum: return update + 3 * R + (2.0 * threads + 2) * C + csr; // zero, scatter, merge
+    case UnitsPushStrategy::Atomic: break;
+    }
+    return update + 3 * R + 4 * C + csr; // accumulator updated, then read and cleared
+}
+
+// "roofline" JSON fields: the DRAM triad peak, the modeled traffic and the share of the peak
+// reached. The step's working set (the state arrays it keeps touching) decides whether the
+// DRAM peak applies: cache-resident grids are also compared with a triad of the same size.
+void print_roofline(const BenchConfig& cfg, double bytes_per_cell_step, double cell_steps_per_s,
+                    double working_set_bytes) {
+    if (!cfg.roofline) return;
+    const double peak = stream_triad_gb_per_s(cfg);
+    const double same_size = stream_triad_gb_per_s(static_cast<std::size_t>(working_set_bytes / 3));
+    const double achieved = bytes_per_cell_step * cell_steps_per_s * 1e-9;
+    const std::size_t llc = last_level_cache_bytes();
+    std::cout << ", \"stream_triad_gb_per_s\": " << peak
+              << ", \"bytes_per_cell_step\": " << bytes_per_cell_step
+              << ", \"effective_gb_per_s\": " << achieved
+              << ", \"percent_of_peak\": " << (peak > 0 ? 100.0 * achieved / peak : 0.0)
+              << ", \"working_set_bytes\": " << static_cast<std::uint64_t>(working_set_bytes)
+              << ", \"cache_resident\": ";
+    if (llc > 0) std::cout << (working_set_bytes <= static_cast<double>(llc) ? "true" : "false");
+    else std::cout << "null";
+    std::cout << ", \"stream_triad_same_size_gb_per_s\": " << same_size
+              << ", \"percent_of_same_size_peak\": " << (same_size > 0 ? 100.0 * achieved / same_size : 0.0);
+}
+
+// Bytes the step keeps live per cell: the four state arrays, plus the CSR neighbor lists
+template <typename Core>
+double working_set_bytes_per_cell(const Core& core) {
+    const double csr = core.neighbor_mode() == UnitsNeighborMode::Explicit ? 9.0 * sizeof(int) : 0.0;
+    return 4.0 * sizeof(typename Core::real_type) + csr;
+}
+
+// Loads the initial grid of cfg into core
+template <typename Real>
+void load_initial_values(UnitsCoreT<Real>& core, const BenchConfig& cfg) {
+    using compute_type = typename UnitsCoreT<Real>::compute_type;
+    const std::vector<double> init = initial_values(cfg);
+    std::vector<Real> values(init.size());
+    for (std::size_t i = 0; i < init.size(); ++i) values[i] = static_cast<compute_type>(init[i]);
+    core.set_values(values);
+}
+
+// Selects the push strategy called `name`; false if it is unknown or not in this build
+template <typename Real>
+bool set_push_strategy_by_name(UnitsCoreT<Real>& core, const std::string& name) {
+    for (UnitsPushStrategy s : UnitsCoreT<Real>::available_push_strategies()) {
+        if (name == UnitsCoreT<Real>::push_strategy_name(s)) {
+            core.set_push_strategy(s);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Advances count steps the way cfg asks for (step_n() passes, step_fused() or step_many())
+template <typename Real>
+void run_steps(UnitsCoreT<Real>& core, const BenchConfig& cfg, int count) {
+    if (cfg.steps_per_pass > 1) {
+        for (int done = 0; done < count; done += cfg.steps_per_pass) {
+            core.step_n(std::min(cfg.steps_per_pass, count - done));
+        }
+    } else if (cfg.fused) {
+        for (int i = 0; i < count; ++i) core.step_fused();
+    } else {
+        core.step_many(count);
+    }
+}
+
+// Log-linear latency histogram in the style of HdrHistogram: values below 32 ns get a bucket
+// each, above that every power of two is split into 32 buckets, so any recorded value is
+// reported within 1/32 (~3%). Fixed size, so recording never allocates and costs a few
+// instructions.
+class LatencyHistogram {
+public:
+    LatencyHistogram() : m_counts(kMagnitudes * kSubBuckets, 0) {}
+
+    void record(std::uint64_t ns)
+    {
+        ++m_counts[index(ns)];
+        ++m_count;
+        m_sum += ns;
+        m_max = std::max(m_max, ns);
+    }
+
+    std::uint64_t count() const { return m_count; }
+    std::uint64_t max() const { return m_max; }
+    double mean() const { return m_count ? static_cast<double>(m_sum) / m_count : 0.0; }
+
+    // Upper edge of the bucket holding the value of rank ceil(p / 100 * count), capped at max()
+    std::uint64_t percentile(double p) const
+    {
+        if (m_count == 0) return 0;
+        const std::uint64_t rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(p / 100.0 * m_count)));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < m_counts.size(); ++i) {
+            seen += m_counts[i];
+            if (seen >= rank) return std::min(upper_edge(i), m_max);
+        }
+        return m_max;
+    }
+
+private:
+    static constexpr int kSubBucketBits = 5;
+    static constexpr std::uint64_t kSubBuckets = std::uint64_t(1) << kSubBucketBits;
+    static constexpr std::size_t kMagnitudes = 64 - kSubBucketBits + 1;
+
+    static int bit_length(std::uint64_t v)
+    {
+#if defined(__GNUC__)
+        return v ? 64 - __builtin_clzll(v) : 0;
+#else
+        int bits = 0;
+        for (; v; v >>= 1) ++bits;
+        return bits;
+#endif
     }
 
+    static std::size_t index(std::uint64_t ns)
+    {
+        if (ns < kSubBuckets) return static_cast<std::size_t>(ns);
+        const int shift = bit_length(ns) - 1 - kSubBucketBits;
+        return static_cast<std::size_t>((shift + 1) * kSubBuckets + ((ns >> shift) - kSubBuckets));
+    }
+
+    static std::uint64_t upper_edge(std::size_t i)
+    {
+        if (i < kSubBuckets) return i;
+        const int shift = static_cast<int>(i / kSubBuckets) - 1;
+        const std::uint64_t sub = kSubBuckets + i % kSubBuckets;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    std::vector<std::uint64_t> m_counts;
+    std::uint64_t m_count = 0;
+    std::uint64_t m_sum = 0;
+    std::uint64_t m_max = 0;
+};
+
+// Steps count steps one call at a time into the histogram. With a frame budget each call
+// starts on the next frame boundary (sleeping until then, as a render loop would) and
+// misses its deadline if it ends after that frame; a late call pushes the schedule back
+// instead of being followed by a burst of catch-up steps. Returns the deadline misses.
+template <typename Real>
+std::uint64_t run_steps_timed(UnitsCoreT<Real>& core, const BenchConfig& cfg, int count, LatencyHistogram& histogram) {
+    using Clock = std::chrono::steady_clock;
+    const int per_call = std::max(cfg.steps_per_pass, 1);
+    const Clock::duration budget = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::milli>(cfg.frame_budget_ms));
+    std::uint64_t misses = 0;
+    Clock::time_point frame = Clock::now();
+    for (int done = 0; done < count; done += per_call) {
+        if (budget.count() > 0) std::this_thread::sleep_until(frame);
+        const Clock::time_point start = Clock::now();
+        const int calls = std::min(per_call, count - done);
+        run_steps(core, cfg, calls);
+        const Clock::time_point end = Clock::now();
+        const std::uint64_t ns = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        for (int i = 0; i < calls; ++i) histogram.record(ns / calls);
+        if (budget.count() > 0) {
+            if (end > frame + budget) ++misses;
+            frame = std::max(frame + budget, end);
+        }
+    }
+    return misses;
+}
+
+template <typename Real>
+int run_benchmark(const BenchConfig& cfg) {
+    using Core = UnitsCoreT<Real>;
     const std::size_t N = static_cast<std::size_t>(cfg.width) * static_cast<std::size_t>(cfg.height);
 
     // Create UnitsCore with random initial values
-    UnitsCore core(cfg.width, cfg.height, 1.0, true);
+    Core core(cfg.width, cfg.height, 1.0, true,
+              cfg.stencil ? UnitsNeighborMode::Stencil : UnitsNeighborMode::Explicit);
+    load_initial_values(core, cfg);
 
-    // Initialize with random values
-    std::mt19937 rng(cfg.seed);
-    std::uniform_real_distribution<units_real> dist(-1.0, 1.0);
-    for (std::size_t i = 0; i < N; ++i) {
-        core.set_value_index(i, dist(rng));
+    if (cfg.thread_pool > 0) {
+        auto pool = std::make_shared<UnitsThreadPool>(cfg.thread_pool);
+        if (cfg.thread_pool > 1 && !pool->pinned()) {
+            std::cerr << "Warning: thread pool workers could not be pinned to CPUs\n";
+        }
+        core.set_thread_pool(std::move(pool));
+    }
+    if (cfg.active_threshold > 0) {
+        core.set_active_set(static_cast<typename Core::compute_type>(cfg.active_threshold), cfg.tile_size);
     }
 
-    // Warmup: run a few steps to ensure everything is loaded into cache
-    for (int i = 0; i < cfg.warmup; ++i) {
-        core.step();
+    // Select push strategy (or autotune it on this grid and thread count)
+    std::vector<UnitsPushTiming> autotune_table;
+    if (cfg.strategy == "auto") {
+        autotune_table = core.autotune();
+        std::cerr << "autotune (" << cfg.width << "x" << cfg.height << "):\n";
+        for (const auto& t : autotune_table) {
+            std::cerr << "  " << Core::push_strategy_name(t.strategy) << ": "
+                      << t.seconds_per_step * 1e3 << " ms/step\n";
+        }
+    } else if (!cfg.strategy.empty() && !set_push_strategy_by_name(core, cfg.strategy)) {
+        std::cerr << "Error: push strategy '" << cfg.strategy << "' is unknown or not available in this build\n";
+        return 1;
     }
 
+    // Warmup: run a few steps to ensure everything is loaded into cache
+    run_steps(core, cfg, cfg.warmup);
+
     // Benchmark: measure steady-state time
+    LatencyHistogram histogram;
+    std::uint64_t deadline_misses = 0;
+    core.reset_stats();
+    const std::size_t allocations_before = g_heap_allocations.load();
+    if (cfg.perf_counters) g_perf_counters.start();
     auto start_time = std::chrono::steady_clock::now();
     
-    for (int i = 0; i < cfg.steps; ++i) {
-        core.step();
+    int steps_taken = cfg.steps;
+    if (cfg.until) {
+        steps_taken = core.step_until(static_cast<typename Core::compute_type>(cfg.epsilon), cfg.steps);
+    } else if (cfg.latency) {
+        deadline_misses = run_steps_timed(core, cfg, cfg.steps, histogram);
+    } else {
+        run_steps(core, cfg, cfg.steps);
     }
     
     auto end_time = std::chrono::steady_clock::now();
+    if (cfg.perf_counters) g_perf_counters.stop();
+    const std::size_t heap_allocations = g_heap_allocations.load() - allocations_before;
     std::chrono::duration<double> elapsed = end_time - start_time;
     double time_s = elapsed.count();
-    double steps_per_s = cfg.steps / time_s;
+    double steps_per_s = steps_taken / time_s;
 
     // Determine number of threads
     int num_threads = 1;
@@ -95,13 +698,27 @@ int main(int argc, char** argv) {
     num_threads = omp_get_max_threads();
 #endif
 
-    // Determine precision
-    const char* precision = 
-#ifdef UNITS_USE_FLOAT
-        "float";
-#else
-        "double";
-#endif
+    // Accuracy of reduced precision: max / RMS difference of the values after the same number
+    // of steps in double (stencil mode, no scratch beyond the four arrays)
+    const bool report_error = cfg.reference && !std::is_same<Real, double>::value;
+    double max_abs_error = 0.0;
+    double rms_error = 0.0;
+    if (report_error) {
+        UnitsCoreT<double> reference(cfg.width, cfg.height, 1.0, true, UnitsNeighborMode::Stencil);
+        load_initial_values(reference, cfg);
+        for (int i = 0; i < cfg.warmup + steps_taken; ++i) reference.step();
+
+        double sum_sq = 0.0;
+        for (std::size_t i = 0; i < N; ++i) {
+            const double err = std::fabs(static_cast<double>(core.value_at_index(i)) - reference.value_at_index(i));
+            max_abs_error = std::max(max_abs_error, err);
+            sum_sq += err * err;
+        }
+        rms_error = std::sqrt(sum_sq / static_cast<double>(N));
+    }
+
+    char state_hash[19];
+    std::snprintf(state_hash, sizeof(state_hash), "%016llx", static_cast<unsigned long long>(core.state_hash()));
 
     // Print results as single JSON line
     std::cout << "{\"width\": " << cfg.width
@@ -110,14 +727,357 @@ int main(int argc, char** argv) {
               << ", \"time_s\": " << time_s
               << ", \"steps_per_s\": " << steps_per_s
               << ", \"use_per_thread_accum\": "
-#ifdef USE_PER_THREAD_ACCUM
-              << "true"
-#else
-              << "false"
+              << (core.push_strategy() == UnitsPushStrategy::PerThreadAccum ? "true" : "false")
+              << ", \"push_strategy\": \"" << Core::push_strategy_name(core.push_strategy()) << "\""
+              << ", \"neighbor_mode\": \"" << (cfg.stencil ? "stencil" : "explicit") << "\""
+              << ", \"fused\": " << (cfg.fused ? "true" : "false")
+              << ", \"steps_per_pass\": " << cfg.steps_per_pass
+              << ", \"threads\": " << num_threads
+              << ", \"precision\": \"" << cfg.precision << "\""
+              << ", \"simd_isa\": \"" << Core::simd_isa() << "\""
+              << ", \"state_hash\": \"" << state_hash << "\""
+              << ", \"heap_allocations\": " << heap_allocations;
+    if (core.thread_pool()) {
+        std::cout << ", \"thread_pool\": " << core.thread_pool()->size();
+    }
+    if (cfg.huge_pages != "off") {
+        std::cout << ", \"huge_pages\": \"" << cfg.huge_pages << "\""
+                  << ", \"huge_page_kb\": " << units_huge_page_bytes() / 1024;
+    }
+    if (cfg.numa_report) {
+        const std::vector<std::size_t> pages = core.numa_pages_per_node();
+        std::cout << ", \"numa_pages\": [";
+        for (std::size_t node = 0; node < pages.size(); ++node) std::cout << (node ? ", " : "") << pages[node];
+        std::cout << "]";
+    }
+    if (core.active_set_enabled()) {
+        std::cout << ", \"active_threshold\": " << cfg.active_threshold
+                  << ", \"tile_size\": " << cfg.tile_size
+                  << ", \"active_tiles\": " << core.active_tile_count();
+    }
+    if (cfg.until) {
+        std::cout << ", \"steps_taken\": " << steps_taken
+                  << ", \"delta_linf\": " << core.delta_norms().linf
+                  << ", \"delta_l2\": " << core.delta_norms().l2;
+    }
+    if (report_error) {
+        std::cout << ", \"max_abs_error\": " << max_abs_error
+                  << ", \"rms_error\": " << rms_error;
+    }
+    print_perf_counters(cfg, static_cast<double>(N) * steps_taken);
+    if (cfg.latency) {
+        std::cout << ", \"latency\": {\"p50_s\": " << histogram.percentile(50) * 1e-9
+                  << ", \"p90_s\": " << histogram.percentile(90) * 1e-9
+                  << ", \"p99_s\": " << histogram.percentile(99) * 1e-9
+                  << ", \"p999_s\": " << histogram.percentile(99.9) * 1e-9
+                  << ", \"max_s\": " << histogram.max() * 1e-9
+                  << ", \"mean_s\": " << histogram.mean() * 1e-9 << "}";
+        if (cfg.frame_budget_ms > 0) {
+            const std::uint64_t frames = (static_cast<std::uint64_t>(steps_taken) + std::max(cfg.steps_per_pass, 1) - 1) /
+                                         std::max(cfg.steps_per_pass, 1);
+            std::cout << ", \"frame_budget_s\": " << cfg.frame_budget_ms * 1e-3
+                      << ", \"frames\": " << frames
+                      << ", \"deadline_misses\": " << deadline_misses
+                      << ", \"deadline_miss_rate\": " << static_cast<double>(deadline_misses) / frames;
+        }
+    }
+    if (core.active_set_enabled()) {
+        if (cfg.roofline) std::cerr << "Note: --roofline is skipped with --active-set (quiet tiles are not stepped)\n";
+    } else {
+        print_roofline(cfg, step_bytes_per_cell(cfg, core, num_threads), static_cast<double>(N) * steps_per_s,
+                       working_set_bytes_per_cell(core) * static_cast<double>(N));
+    }
+    if (Core::stats_enabled()) {
+        // Per-phase breakdown of the timed steps (USE_STATS builds)
+        const UnitsStats& stats = core.stats();
+        const double steps_recorded = static_cast<double>(std::max<std::uint64_t>(stats.steps, 1));
+        std::cout << ", \"stats_steps\": " << stats.steps << ", \"stats\": {";
+        bool first = true;
+        for (int p = 0; p < kUnitsPhaseCount; ++p) {
+            const UnitsPhaseStats& phase = stats.phases[p];
+            if (phase.calls == 0) continue;
+            std::cout << (first ? "" : ", ") << "\"" << Core::phase_name(static_cast<UnitsPhase>(p)) << "\": {"
+                      << "\"s\": " << phase.seconds
+                      << ", \"calls\": " << phase.calls
+                      << ", \"bytes_per_step\": " << static_cast<double>(phase.bytes) / steps_recorded
+                      << ", \"gb_per_s\": " << (phase.seconds > 0 ? phase.bytes / phase.seconds * 1e-9 : 0.0)
+                      << "}";
+            first = false;
+        }
+        std::cout << "}";
+    }
+    if (!autotune_table.empty()) {
+        std::cout << ", \"autotune\": [";
+        for (std::size_t i = 0; i < autotune_table.size(); ++i) {
+            std::cout << (i ? ", " : "") << "{\"strategy\": \""
+                      << Core::push_strategy_name(autotune_table[i].strategy)
+                      << "\", \"s_per_step\": " << autotune_table[i].seconds_per_step << "}";
+        }
+        std::cout << "]";
+    }
+    std::cout << "}\n";
+
+    return 0;
+}
+
+// K grids in one UnitsEnsembleT; reports whole-ensemble steps and per-instance step throughput
+template <typename Real>
+int run_ensemble_benchmark(const BenchConfig& cfg) {
+    using Ensemble = UnitsEnsembleT<Real>;
+    Ensemble ensemble(cfg.width, cfg.height, cfg.ensemble);
+
+    BenchConfig instance_cfg = cfg;
+    for (int k = 0; k < cfg.ensemble; ++k) {
+        instance_cfg.seed = cfg.seed + static_cast<unsigned int>(k);
+        const std::vector<double> init = initial_values(instance_cfg);
+        for (std::size_t i = 0; i < init.size(); ++i) {
+            ensemble.set_value_index(k, i, static_cast<typename Ensemble::compute_type>(init[i]));
+        }
+    }
+
+    for (int i = 0; i < cfg.warmup; ++i) ensemble.step();
+
+    const std::size_t allocations_before = g_heap_allocations.load();
+    if (cfg.perf_counters) g_perf_counters.start();
+    auto start_time = std::chrono::steady_clock::now();
+    for (int i = 0; i < cfg.steps; ++i) ensemble.step();
+    auto end_time = std::chrono::steady_clock::now();
+    if (cfg.perf_counters) g_perf_counters.stop();
+    const std::size_t heap_allocations = g_heap_allocations.load() - allocations_before;
+    std::chrono::duration<double> elapsed = end_time - start_time;
+    double time_s = elapsed.count();
+    double steps_per_s = cfg.steps / time_s;
+
+    int num_threads = 1;
+#ifdef _OPENMP
+    num_threads = omp_get_max_threads();
 #endif
+
+    std::cout << "{\"width\": " << cfg.width
+              << ", \"height\": " << cfg.height
+              << ", \"steps\": " << cfg.steps
+              << ", \"time_s\": " << time_s
+              << ", \"steps_per_s\": " << steps_per_s
+              << ", \"instances\": " << cfg.ensemble
+              << ", \"instance_steps_per_s\": " << steps_per_s * cfg.ensemble
               << ", \"threads\": " << num_threads
-              << ", \"precision\": \"" << precision << "\""
-              << "}\n";
+              << ", \"precision\": \"" << cfg.precision << "\""
+              << ", \"simd_isa\": \"" << UnitsCoreT<Real>::simd_isa() << "\""
+              << ", \"heap_allocations\": " << heap_allocations;
+    print_perf_counters(cfg, static_cast<double>(ensemble.cells()) * cfg.ensemble * cfg.steps);
+    // Integrate pass (4 reads, 2 writes) and gather pass (deltas in, delta_steps out) per cell
+    const double instance_cells = static_cast<double>(ensemble.cells()) * cfg.ensemble;
+    print_roofline(cfg, 8.0 * sizeof(Real), instance_cells * steps_per_s, 4.0 * sizeof(Real) * instance_cells);
+    std::cout << "}\n";
+    return 0;
+}
+
+// Per-step latency statistics over all samples of one sweep configuration
+struct LatencyStats {
+    double median, min, mean, stddev, p95;
+};
+
+LatencyStats latency_stats(std::vector<double>& samples) {
+    std::sort(samples.begin(), samples.end());
+    const std::size_t n = samples.size();
+    LatencyStats stats;
+    stats.median = n % 2 ? samples[n / 2] : 0.5 * (samples[n / 2 - 1] + samples[n / 2]);
+    stats.min = samples.front();
+    stats.p95 = samples[static_cast<std::size_t>(std::ceil(0.95 * n)) - 1]; // nearest rank
+    double sum = 0.0;
+    for (double s : samples) sum += s;
+    stats.mean = sum / n;
+    double sum_sq = 0.0;
+    for (double s : samples) sum_sq += (s - stats.mean) * (s - stats.mean);
+    stats.stddev = n > 1 ? std::sqrt(sum_sq / (n - 1)) : 0.0;
+    return stats;
+}
+
+// --sweep: every size x thread count x strategy, each on `repeats` freshly built grids (so
+// allocation and page placement vary too) with warmup, then every step timed on its own.
+// Calls that advance several steps (--steps-per-pass) count as that many equal steps.
+template <typename Real>
+int run_sweep(const BenchConfig& cfg) {
+    using Core = UnitsCoreT<Real>;
 
+    std::vector<std::pair<int, int>> sizes;
+    for (const std::string& item : split_list(cfg.sizes)) {
+        const std::size_t x = item.find('x');
+        const int w = std::stoi(item.substr(0, x));
+        const int h = x == std::string::npos ? w : std::stoi(item.substr(x + 1));
+        if (w <= 0 || h <= 0) {
+            std::cerr << "Error: sweep size '" << item << "' must be positive\n";
+            return 1;
+        }
+        sizes.emplace_back(w, h);
+    }
+    if (sizes.empty()) sizes.emplace_back(cfg.width, cfg.height);
+
+    int default_threads = 1;
+#ifdef _OPENMP
+    default_threads = omp_get_max_threads();
+#endif
+    std::vector<int> thread_counts;
+    for (const std::string& item : split_list(cfg.threads)) thread_counts.push_back(std::stoi(item));
+    if (thread_counts.empty()) thread_counts.push_back(default_threads);
+    for (int t : thread_counts) {
+#ifdef _OPENMP
+        const bool valid = t > 0;
+#else
+        const bool valid = t == 1;
+#endif
+        if (!valid) {
+            std::cerr << "Error: sweep thread count " << t << " is not available in this build\n";
+            return 1;
+        }
+    }
+
+    std::vector<std::string> available;
+    for (UnitsPushStrategy s : Core::available_push_strategies()) available.push_back(Core::push_strategy_name(s));
+    std::vector<std::string> strategies = split_list(cfg.strategies);
+    if (strategies.empty()) strategies = available;
+    for (const std::string& strategy : strategies) {
+        if (std::find(available.begin(), available.end(), strategy) == available.end()) {
+            std::cerr << "Error: push strategy '" << strategy << "' is unknown or not available in this build\n";
+            return 1;
+        }
+    }
+
+    std::cout << "{\"sweep\": {\"precision\": \"" << cfg.precision << "\""
+              << ", \"simd_isa\": \"" << Core::simd_isa() << "\""
+              << ", \"neighbor_mode\": \"" << (cfg.stencil ? "stencil" : "explicit") << "\""
+              << ", \"fused\": " << (cfg.fused ? "true" : "false")
+              << ", \"steps_per_pass\": " << cfg.steps_per_pass
+              << ", \"steps\": " << cfg.steps
+              << ", \"warmup\": " << cfg.warmup
+              << ", \"repeats\": " << cfg.repeats << "},\n \"results\": [";
+
+    const int per_call = std::max(cfg.steps_per_pass, 1);
+    std::vector<double> samples;
+    std::vector<double> repeat_steps_per_s;
+    samples.reserve(static_cast<std::size_t>(cfg.repeats) * cfg.steps); // no allocation while timing
+    repeat_steps_per_s.reserve(cfg.repeats);
+    bool first = true;
+    for (const auto& size : sizes) {
+        BenchConfig run_cfg = cfg;
+        run_cfg.width = size.first;
+        run_cfg.height = size.second;
+        for (int threads : thread_counts) {
+#ifdef _OPENMP
+            omp_set_num_threads(threads); // before the grid is built, so first touch matches
+#endif
+            for (const std::string& strategy : strategies) {
+                samples.clear();
+                repeat_steps_per_s.clear();
+                std::size_t heap_allocations = 0;
+                for (int r = 0; r < cfg.repeats; ++r) {
+                    Core core(run_cfg.width, run_cfg.height, 1.0, true,
+                              cfg.stencil ? UnitsNeighborMode::Stencil : UnitsNeighborMode::Explicit);
+                    load_initial_values(core, run_cfg);
+                    if (cfg.active_threshold > 0) {
+                        core.set_active_set(static_cast<typename Core::compute_type>(cfg.active_threshold), cfg.tile_size);
+                    }
+                    set_push_strategy_by_name(core, strategy);
+                    run_steps(core, cfg, cfg.warmup);
+
+                    const std::size_t allocations_before = g_heap_allocations.load();
+                    double total = 0.0;
+                    for (int done = 0; done < cfg.steps; done += per_call) {
+                        const int count = std::min(per_call, cfg.steps - done);
+                        const auto start = std::chrono::steady_clock::now();
+                        run_steps(core, cfg, count);
+                        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                        for (int i = 0; i < count; ++i) samples.push_back(elapsed.count() / count);
+                        total += elapsed.count();
+                    }
+                    heap_allocations += g_heap_allocations.load() - allocations_before;
+                    repeat_steps_per_s.push_back(cfg.steps / total);
+                }
+
+                const LatencyStats stats = latency_stats(samples);
+                std::sort(repeat_steps_per_s.begin(), repeat_steps_per_s.end());
+                std::cout << (first ? "\n  " : ",\n  ")
+                          << "{\"width\": " << run_cfg.width
+                          << ", \"height\": " << run_cfg.height
+                          << ", \"threads\": " << threads
+                          << ", \"push_strategy\": \"" << strategy << "\""
+                          << ", \"samples\": " << samples.size()
+                          << ", \"median_s\": " << stats.median
+                          << ", \"min_s\": " << stats.min
+                          << ", \"mean_s\": " << stats.mean
+                          << ", \"stddev_s\": " << stats.stddev
+                          << ", \"p95_s\": " << stats.p95
+                          << ", \"steps_per_s\": " << repeat_steps_per_s[repeat_steps_per_s.size() / 2]
+                          << ", \"heap_allocations\": " << heap_allocations << "}";
+                first = false;
+            }
+        }
+    }
+    std::cout << "\n]}\n";
     return 0;
 }
+
+template <typename Real>
+int run(const BenchConfig& cfg) {
+    if (cfg.sweep) return run_sweep<Real>(cfg);
+    return cfg.ensemble > 0 ? run_ensemble_benchmark<Real>(cfg) : run_benchmark<Real>(cfg);
+}
+
+int main(int argc, char** argv) {
+    BenchConfig cfg = parse_args(argc, argv);
+
+    // Validate inputs
+    if (cfg.width <= 0 || cfg.height <= 0 || cfg.steps <= 0 || cfg.steps_per_pass <= 0 || cfg.tile_size <= 0) {
+        std::cerr << "Error: width, height, steps, steps-per-pass, and tile-size must be positive\n";
+        return 1;
+    }
+    if (cfg.init != "random" && cfg.init != "center" && cfg.init != "edges") {
+        std::cerr << "Error: init must be random, center or edges\n";
+        return 1;
+    }
+
+    if (cfg.ensemble < 0 || cfg.thread_pool < 0 || cfg.stream_mb < 0) {
+        std::cerr << "Error: ensemble, thread-pool and stream-mb must be >= 0\n";
+        return 1;
+    }
+    if (cfg.latency && (cfg.until || cfg.frame_budget_ms < 0)) {
+        std::cerr << "Error: --latency / --frame-budget need a budget >= 0 and do not combine with --until\n";
+        return 1;
+    }
+    if (cfg.sweep && (cfg.repeats <= 0 || cfg.ensemble > 0 || cfg.thread_pool > 0 || cfg.until)) {
+        std::cerr << "Error: --sweep needs repeats > 0 and does not combine with --ensemble, --thread-pool or --until\n";
+        return 1;
+    }
+
+    // Before any OpenMP region or pool thread exists, so that inherited counters cover them
+    if (cfg.perf_counters && !g_perf_counters.open()) {
+        std::cerr << "Warning: hardware counters unavailable (" << g_perf_counters.error() << ")\n";
+    }
+
+    if (!cfg.trace.empty()) {
+#if defined(USE_TRACE)
+        // The rings keep each thread's latest events, i.e. the end of the timed steps
+        units_trace_start(cfg.trace.c_str());
+#else
+        std::cerr << "Warning: --trace needs a build with -DUSE_TRACE=ON; no trace written\n";
+#endif
+    }
+
+    if (cfg.huge_pages == "thp") units_set_huge_pages(UnitsHugePages::Transparent);
+    else if (cfg.huge_pages == "explicit") units_set_huge_pages(UnitsHugePages::Explicit);
+    else if (cfg.huge_pages != "off") {
+        std::cerr << "Error: huge-pages must be off, thp or explicit\n";
+        return 1;
+    }
+
+    if (cfg.pin && !units_pin_openmp_threads()) {
+        std::cerr << "Warning: --pin could not pin every OpenMP thread (needs OpenMP on Linux)\n";
+    }
+
+    if (cfg.precision == "float") return run<float>(cfg);
+    if (cfg.precision == "double") return run<double>(cfg);
+    if (cfg.precision == "half") return run<units_half>(cfg);
+    if (cfg.precision == "bfloat16") return run<units_bfloat16>(cfg);
+    std::cerr << "Error: precision must be double, float, half or bfloat16\n";
+    return 1;
+}
@@ -40,11 +40,9 @@ int main(int argc, char** argv) {
     // Initialize with random values
     std::mt19937_64 rng(seed);
     std::uniform_real_distribution<units_real> dist(-1.0, 1.0);
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            core.set_value(x, y, dist(rng));
-        }
-    }
+    std::vector<units_real> init(static_cast<std::size_t>(width) * height);
+    for (auto& v : init) v = dist(rng);
+    core.set_values(init);
 
     for (int step = 0; step < steps; ++step) {
         // Run one simulation step
@@ -3,8 +3,13 @@
 #include <iostream>
 #include <random>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #ifdef USE_GPU_COLORMAP
@@ -17,6 +22,8 @@ struct ViewerConfig {
     int height = 256;
     int scale = 2;
     int target_fps = 30;
+    double sim_rate = 0.0; // steps/s target for the simulation thread, 0 = unlimited
+    int publish_every = 1; // steps between published snapshots
     int scenario = 0; // 0=random, 1=center, 2=edges
 };
 
@@ -32,6 +39,10 @@ ViewerConfig parse_args(int argc, char** argv) {
             cfg.scale = std::stoi(argv[++i]);
         } else if (arg == "--fps" && i + 1 < argc) {
             cfg.target_fps = std::stoi(argv[++i]);
+        } else if (arg == "--sim-rate" && i + 1 < argc) {
+            cfg.sim_rate = std::stod(argv[++i]);
+        } else if (arg == "--publish-every" && i + 1 < argc) {
+            cfg.publish_every = std::stoi(argv[++i]);
         } else if (arg == "--scenario" && i + 1 < argc) {
             cfg.scenario = std::stoi(argv[++i]);
         } else if (arg == "--help") {
@@ -39,7 +50,9 @@ ViewerConfig parse_args(int argc, char** argv) {
                       << "  --width <W>      Grid width (default: 256)\n"
                       << "  --height <H>     Grid height (default: 256)\n"
                       << "  --scale <S>      Pixel scale factor (default: 2)\n"
-                      << "  --fps <F>        Target FPS (default: 30)\n"
+                      << "  --fps <F>        Target display FPS (default: 30)\n"
+                      << "  --sim-rate <S>   Simulation steps/s target, 0 = unlimited (default: 0)\n"
+                      << "  --publish-every <N>  Steps between frames handed to the display (default: 1)\n"
                       << "  --scenario <N>   Initial scenario: 0=random, 1=center, 2=edges (default: 0)\n"
                       << "  --help           Show this help\n";
             std::exit(0);
@@ -49,7 +62,7 @@ ViewerConfig parse_args(int argc, char** argv) {
 }
 
 // Helper function to convert units_real values to RGBA pixels
-void convert_to_rgba(const std::vector<units_real>& values, std::vector<uint8_t>& pixels, int width, int height) {
+void convert_to_rgba(UnitsSpan<const units_real> values, std::vector<uint8_t>& pixels, int width, int height) {
     if (values.empty()) {
         pixels.clear();
         return;
@@ -112,7 +125,7 @@ public:
         return true;
     }
     
-    void upload(const std::vector<units_real>& values) {
+    void upload(UnitsSpan<const units_real> values) {
         if (!m_initialized || values.size() != static_cast<size_t>(m_width * m_height)) return;
         
         // Upload to texture via PBO for better performance
@@ -195,6 +208,10 @@ int main(int argc, char** argv) {
         std::cerr << "Error: width, height, and scale must be positive\n";
         return 1;
     }
+    if (cfg.target_fps <= 0 || cfg.publish_every <= 0 || cfg.sim_rate < 0) {
+        std::cerr << "Error: fps and publish-every must be positive, sim-rate non-negative\n";
+        return 1;
+    }
     
     // Initialize SDL
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
@@ -301,46 +318,83 @@ int main(int argc, char** argv) {
     
     const std::size_t N = static_cast<std::size_t>(cfg.width) * static_cast<std::size_t>(cfg.height);
     
+    std::vector<units_real> init(N, 0.0);
     if (cfg.scenario == 0) {
         // Random initialization
         for (std::size_t i = 0; i < N; ++i) {
-            core.set_value_index(i, dist(rng));
+            init[i] = dist(rng);
         }
     } else if (cfg.scenario == 1) {
         // Center stimulus
-        for (std::size_t i = 0; i < N; ++i) {
-            core.set_value_index(i, 0.0);
-        }
         int cx = cfg.width / 2;
         int cy = cfg.height / 2;
-        core.set_value(cx, cy, 1.0);
+        init[static_cast<std::size_t>(cy) * cfg.width + cx] = 1.0;
     } else if (cfg.scenario == 2) {
         // Edge stimulus
-        for (std::size_t i = 0; i < N; ++i) {
-            core.set_value_index(i, 0.0);
-        }
         for (int x = 0; x < cfg.width; ++x) {
-            core.set_value(x, 0, 1.0);
-            core.set_value(x, cfg.height - 1, 1.0);
+            init[x] = 1.0;
+            init[static_cast<std::size_t>(cfg.height - 1) * cfg.width + x] = 1.0;
         }
         for (int y = 0; y < cfg.height; ++y) {
-            core.set_value(0, y, 1.0);
-            core.set_value(cfg.width - 1, y, 1.0);
+            init[static_cast<std::size_t>(y) * cfg.width] = 1.0;
+            init[static_cast<std::size_t>(y) * cfg.width + cfg.width - 1] = 1.0;
         }
     }
+    core.set_values(init);
+    
+    // The simulation thread publishes snapshots of the values; the render loop only reads them
+    core.enable_snapshots(cfg.publish_every);
+    core.publish_snapshot(); // initial state, shown until the first published step
     
 #ifndef USE_GPU_COLORMAP
     std::vector<uint8_t> pixels;  // Only needed for CPU path
 #endif
-    bool running = true;
+    std::atomic<bool> running{ true };
     SDL_Event event;
     
     const Uint32 frame_delay = 1000 / cfg.target_fps;
     
     std::cout << "Realtime viewer started. Press ESC or close window to exit.\n";
-    std::cout << "Grid: " << cfg.width << "x" << cfg.height << ", Scale: " << cfg.scale << ", Target FPS: " << cfg.target_fps << "\n";
+    std::cout << "Grid: " << cfg.width << "x" << cfg.height << ", Scale: " << cfg.scale << ", Target FPS: " << cfg.target_fps
+              << ", Sim rate: ";
+    if (cfg.sim_rate > 0) std::cout << cfg.sim_rate << " steps/s\n";
+    else std::cout << "unlimited\n";
+    
+    // Simulation thread: steps free of the display, paced to sim_rate when one is set
+    std::thread sim_thread([&core, &running, &cfg] {
+        using clock = std::chrono::steady_clock;
+        const clock::time_point start = clock::now();
+        std::uint64_t steps = 0;
+        while (running.load(std::memory_order_relaxed)) {
+            if (cfg.sim_rate <= 0) {
+                core.step();
+                continue;
+            }
+            // Step while behind schedule, sleep until the next step is due otherwise. A backlog
+            // of more than 0.1 s (the core is slower than sim_rate) is dropped, not burst through.
+            const double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+            const std::uint64_t due = static_cast<std::uint64_t>(elapsed * cfg.sim_rate);
+            const std::uint64_t max_backlog = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(cfg.sim_rate / 10));
+            if (due > steps + max_backlog) steps = due - max_backlog;
+            if (steps < due) {
+                core.step();
+                ++steps;
+            } else {
+                std::this_thread::sleep_until(start + std::chrono::duration_cast<clock::duration>(
+                    std::chrono::duration<double>((steps + 1) / cfg.sim_rate)));
+            }
+        }
+    });
+    
+    UnitsSnapshotReader<units_real> reader = core.snapshot_reader();
+    std::uint64_t shown_step = ~std::uint64_t(0);
     
-    while (running) {
+    // Readout: simulation steps/s (from the published step numbers) vs displayed frames/s
+    Uint32 readout_start = SDL_GetTicks();
+    std::uint64_t readout_step = 0;
+    int readout_frames = 0;
+    
+    while (running.load(std::memory_order_relaxed)) {
         Uint32 frame_start = SDL_GetTicks();
         
         // Handle events
@@ -354,25 +408,46 @@ int main(int argc, char** argv) {
             }
         }
         
-        // Step simulation
-        core.step();
+        // Pick up the latest published state; redraw the texture only when it changed
+        if (reader.acquire() && reader.step() != shown_step) {
+            shown_step = reader.step();
+            UnitsSpan<const units_real> values(reader.data(), reader.size());
+#ifdef USE_GPU_COLORMAP
+            gpu_renderer.upload(values);
+#else
+            convert_to_rgba(values, pixels, cfg.width, cfg.height);
+            SDL_UpdateTexture(texture, nullptr, pixels.data(), cfg.width * 4);
+#endif
+        }
         
 #ifdef USE_GPU_COLORMAP
         // GPU rendering path
-        gpu_renderer.upload(core.values());
-        
         glClear(GL_COLOR_BUFFER_BIT);
         gpu_renderer.render();
         SDL_GL_SwapWindow(window);
 #else
         // CPU rendering path
-        convert_to_rgba(core.values(), pixels, cfg.width, cfg.height);
-        SDL_UpdateTexture(texture, nullptr, pixels.data(), cfg.width * 4);
-        
         SDL_RenderClear(renderer);
         SDL_RenderCopy(renderer, texture, nullptr, nullptr);
         SDL_RenderPresent(renderer);
 #endif
+        ++readout_frames;
+        
+        const Uint32 now = SDL_GetTicks();
+        if (now - readout_start >= 1000 && reader.valid()) {
+            const double seconds = (now - readout_start) / 1000.0;
+            const double sim_steps_per_s = (reader.step() - readout_step) / seconds;
+            const double fps = readout_frames / seconds;
+            std::ostringstream readout;
+            readout.setf(std::ios::fixed);
+            readout.precision(1);
+            readout << "sim " << sim_steps_per_s << " steps/s | display " << fps << " fps | step " << reader.step();
+            SDL_SetWindowTitle(window, ("Units Realtime Viewer - " + readout.str()).c_str());
+            std::cout << readout.str() << "\n";
+            readout_start = now;
+            readout_step = reader.step();
+            readout_frames = 0;
+        }
         
         // Frame rate control
         Uint32 frame_time = SDL_GetTicks() - frame_start;
@@ -381,6 +456,9 @@ int main(int argc, char** argv) {
         }
     }
     
+    sim_thread.join();
+    reader.release();
+    
     // Cleanup
 #ifdef USE_GPU_COLORMAP
     SDL_GL_DeleteContext(gl_context);
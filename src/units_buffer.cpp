@@ -0,0 +1,200 @@
+#include "units_buffer.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+std::atomic<UnitsHugePages> g_huge_pages{ UnitsHugePages::Off };
+
+// Large buffers start at a rotating offset of 0..7 x 33 cache lines past their 2 MB boundary.
+// Otherwise values[i], deltas[i], delta_steps[i] and targets[i] share their low 21 address
+// bits, which with huge pages means the same physical cache sets, and the streams evict each
+// other (measured ~20% slower at 4096x4096 before staggering).
+constexpr std::size_t kColorStride = 33 * kUnitsBufferAlignment;
+constexpr unsigned kColors = 8;
+constexpr std::size_t kColorPadding = kColors * kColorStride;
+std::atomic<unsigned> g_next_color{ 0 };
+
+#if defined(__linux__)
+inline std::size_t round_up_huge(std::size_t bytes)
+{
+    return (bytes + kUnitsHugePageBytes - 1) & ~(kUnitsHugePageBytes - 1);
+}
+
+// Anonymous mapping of `bytes` (a multiple of 2 MB) starting on a 2 MB boundary: map 2 MB
+// extra and trim both ends, so that transparent huge pages can back every page of it
+void* map_huge_aligned(std::size_t bytes)
+{
+    const std::size_t padded = bytes + kUnitsHugePageBytes;
+    void* raw = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return nullptr;
+    const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(raw);
+    const std::uintptr_t aligned = (begin + kUnitsHugePageBytes - 1) & ~(kUnitsHugePageBytes - 1);
+    if (aligned > begin) munmap(raw, aligned - begin);
+    const std::uintptr_t tail = begin + padded - (aligned + bytes);
+    if (tail > 0) munmap(reinterpret_cast<void*>(aligned + bytes), tail);
+    return reinterpret_cast<void*>(aligned);
+}
+#endif
+
+} // namespace
+
+void units_set_huge_pages(UnitsHugePages mode)
+{
+    g_huge_pages.store(mode, std::memory_order_relaxed);
+}
+
+UnitsHugePages units_huge_pages()
+{
+    return g_huge_pages.load(std::memory_order_relaxed);
+}
+
+void* units_buffer_allocate(std::size_t bytes)
+{
+    if (bytes == 0) bytes = 1;
+#if defined(__linux__)
+    // Large buffers are mapped directly whatever the mode, so that units_buffer_free() can tell
+    // them apart by size alone. Fresh mappings are untouched, which keeps first-touch placement.
+    if (bytes >= kUnitsHugePageBytes) {
+        const std::size_t length = round_up_huge(bytes + kColorPadding);
+        const std::size_t offset = (g_next_color.fetch_add(1, std::memory_order_relaxed) % kColors) * kColorStride;
+        const UnitsHugePages mode = units_huge_pages();
+        void* p = nullptr;
+        if (mode == UnitsHugePages::Explicit) {
+            p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p == MAP_FAILED) p = nullptr;
+        }
+        if (!p) {
+            p = map_huge_aligned(length);
+            if (!p) throw std::bad_alloc();
+            if (mode != UnitsHugePages::Off) madvise(p, length, MADV_HUGEPAGE);
+        }
+        return static_cast<char*>(p) + offset;
+    }
+#endif
+    return ::operator new(bytes, std::align_val_t(kUnitsBufferAlignment));
+}
+
+void units_buffer_free(void* p, std::size_t bytes) noexcept
+{
+    if (!p) return;
+    if (bytes == 0) bytes = 1;
+#if defined(__linux__)
+    if (bytes >= kUnitsHugePageBytes) {
+        // The mapping starts at the 2 MB boundary below the colored pointer
+        const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(p) & ~(kUnitsHugePageBytes - 1);
+        munmap(reinterpret_cast<void*>(base), round_up_huge(bytes + kColorPadding));
+        return;
+    }
+#endif
+    ::operator delete(p, std::align_val_t(kUnitsBufferAlignment));
+}
+
+std::size_t units_huge_page_bytes()
+{
+    std::size_t total_kb = 0;
+#if defined(__linux__)
+    std::FILE* f = std::fopen("/proc/self/smaps_rollup", "r");
+    if (!f) return 0;
+    char line[256];
+    while (std::fgets(line, sizeof(line), f)) {
+        unsigned long kb = 0;
+        if (std::sscanf(line, "AnonHugePages: %lu kB", &kb) == 1 ||
+            std::sscanf(line, "Private_Hugetlb: %lu kB", &kb) == 1 ||
+            std::sscanf(line, "Shared_Hugetlb: %lu kB", &kb) == 1) {
+            total_kb += kb;
+        }
+    }
+    std::fclose(f);
+#endif
+    return total_kb * 1024;
+}
+
+std::vector<std::size_t> units_numa_pages_per_node(const void* data, std::size_t bytes)
+{
+    std::vector<std::size_t> pages_per_node;
+#if defined(__linux__) && defined(SYS_move_pages)
+    if (!data || bytes == 0) return pages_per_node;
+
+    const std::uintptr_t page_size = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+    const std::uintptr_t first = reinterpret_cast<std::uintptr_t>(data) & ~(page_size - 1);
+    const std::uintptr_t last = reinterpret_cast<std::uintptr_t>(data) + bytes;
+
+    // move_pages() with no target nodes only reports the node of each page
+    constexpr std::size_t kBatch = 4096;
+    void* pages[kBatch];
+    int status[kBatch];
+    for (std::uintptr_t page = first; page < last;) {
+        std::size_t count = 0;
+        for (; count < kBatch && page < last; ++count, page += page_size) {
+            pages[count] = reinterpret_cast<void*>(page);
+        }
+        if (syscall(SYS_move_pages, 0, count, pages, nullptr, status, 0) != 0) return {};
+        for (std::size_t i = 0; i < count; ++i) {
+            if (status[i] < 0) continue; // not faulted in yet
+            const std::size_t node = static_cast<std::size_t>(status[i]);
+            if (pages_per_node.size() <= node) pages_per_node.resize(node + 1, 0);
+            ++pages_per_node[node];
+        }
+    }
+#else
+    (void)data;
+    (void)bytes;
+#endif
+    return pages_per_node;
+}
+
+std::vector<int> units_allowed_cpus()
+{
+    std::vector<int> cpus;
+#if defined(__linux__)
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+    }
+#endif
+    return cpus;
+}
+
+bool units_pin_current_thread(const std::vector<int>& cpus, int slot)
+{
+#if defined(__linux__)
+    if (cpus.empty() || slot < 0) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpus[static_cast<std::size_t>(slot) % cpus.size()], &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    (void)slot;
+    return false;
+#endif
+}
+
+bool units_pin_openmp_threads()
+{
+#if defined(_OPENMP)
+    const std::vector<int> cpus = units_allowed_cpus();
+    if (cpus.empty()) return false;
+
+    bool ok = true;
+    #pragma omp parallel reduction(&& : ok)
+    {
+        ok = units_pin_current_thread(cpus, omp_get_thread_num());
+    }
+    return ok;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,254 @@
+#ifndef UNITS_BUFFER_H
+#define UNITS_BUFFER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Storage for the engine's per-cell buffers.
+//
+// Linux places a page on the NUMA node of the thread that first writes it. std::vector's
+// assign()/resize() zero every element on the calling thread, so a grid built by one thread
+// lives entirely on that thread's socket, and the other socket's threads stream it across the
+// interconnect every step. units_allocator default-initializes instead (no write for trivial
+// types), and units_first_touch() then writes the buffer with the same static partition as
+// the stepping loops (thread t owns [n * t / T, n * (t + 1) / T)), so every thread's slice is
+// local to it, provided threads stay on their CPUs (OMP_PROC_BIND / bench --pin).
+//
+// Allocations are 64-byte aligned (a cache line, and an AVX-512 vector), so SIMD loads from
+// the start of a buffer never straddle lines. Buffers of at least kUnitsHugePageBytes are
+// mapped directly, 2 MB aligned, and can be backed by huge pages to cut dTLB misses on large
+// grids (see units_set_huge_pages()).
+
+// Huge-page backing for large engine buffers (process-wide, applies to later allocations):
+// - Off:         no advice: the system's THP default (4 KB pages unless THP is "always")
+// - Transparent: madvise(MADV_HUGEPAGE), honoured when THP is "madvise" or "always"
+// - Explicit:    MAP_HUGETLB from the reserved pool (vm.nr_hugepages), falling back to
+//                Transparent when the pool is too small
+enum class UnitsHugePages { Off, Transparent, Explicit };
+
+void units_set_huge_pages(UnitsHugePages mode);
+UnitsHugePages units_huge_pages();
+
+constexpr std::size_t kUnitsBufferAlignment = 64;
+constexpr std::size_t kUnitsHugePageBytes = std::size_t(2) << 20;
+
+// Raw storage behind units_allocator; bytes must be passed back unchanged to free
+void* units_buffer_allocate(std::size_t bytes);
+void units_buffer_free(void* p, std::size_t bytes) noexcept;
+
+// Bytes of this process backed by huge pages (transparent + explicit), from
+// /proc/self/smaps_rollup; 0 where unavailable
+std::size_t units_huge_page_bytes();
+
+template <typename T>
+struct units_allocator {
+    using value_type = T;
+
+    units_allocator() = default;
+    template <typename U>
+    units_allocator(const units_allocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n)
+    {
+        if (n > static_cast<std::size_t>(-1) / sizeof(T)) throw std::bad_alloc();
+        return static_cast<T*>(units_buffer_allocate(n * sizeof(T)));
+    }
+    void deallocate(T* p, std::size_t n) noexcept { units_buffer_free(p, n * sizeof(T)); }
+
+    // Default-insertion leaves trivial types uninitialized: the first write decides placement
+    template <typename U>
+    void construct(U* p) noexcept { ::new (static_cast<void*>(p)) U; }
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args) { ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...); }
+};
+
+template <typename T, typename U>
+bool operator==(const units_allocator<T>&, const units_allocator<U>&) { return true; }
+template <typename T, typename U>
+bool operator!=(const units_allocator<T>&, const units_allocator<U>&) { return false; }
+
+template <typename T>
+using units_vector = std::vector<T, units_allocator<T>>;
+
+// Replaces v with n copies of value, first-touched in parallel with the static partition
+template <typename T>
+void units_first_touch(units_vector<T>& v, std::size_t n, const T& value)
+{
+    units_vector<T>().swap(v); // drop the old pages so that the new ones are placed fresh
+    v.resize(n);
+    T* data = v.data();
+#ifdef _OPENMP
+    #pragma omp parallel
+#endif
+    {
+        int tid = 0;
+        int num_threads = 1;
+#ifdef _OPENMP
+        tid = omp_get_thread_num();
+        num_threads = omp_get_num_threads();
+#endif
+        const std::size_t begin = n * tid / num_threads;
+        const std::size_t end = n * (tid + 1) / num_threads;
+        for (std::size_t i = begin; i < end; ++i) data[i] = value;
+    }
+}
+
+// Copies n elements from src to dst with the same static partition, so each thread writes
+// (and, for a fresh buffer, places) the slice it will step
+template <typename T>
+void units_parallel_copy(const T* src, T* dst, std::size_t n)
+{
+#ifdef _OPENMP
+    #pragma omp parallel
+#endif
+    {
+        int tid = 0;
+        int num_threads = 1;
+#ifdef _OPENMP
+        tid = omp_get_thread_num();
+        num_threads = omp_get_num_threads();
+#endif
+        const std::size_t begin = n * tid / num_threads;
+        const std::size_t end = n * (tid + 1) / num_threads;
+        for (std::size_t i = begin; i < end; ++i) dst[i] = src[i];
+    }
+}
+
+// Non-owning view of n contiguous elements (std::span stand-in). Binds to anything with
+// data() and size(): std::vector with any allocator, units_vector, another span.
+template <typename T>
+class UnitsSpan {
+public:
+    using value_type = std::remove_cv_t<T>;
+
+    UnitsSpan() = default;
+    UnitsSpan(T* data, std::size_t size) : m_data(data), m_size(size) {}
+    template <typename Container,
+              typename = std::enable_if_t<std::is_convertible<decltype(std::declval<Container&>().data()), T*>::value>>
+    UnitsSpan(Container& c) : m_data(c.data()), m_size(c.size()) {}
+
+    T* data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    T& operator[](std::size_t i) const { return m_data[i]; }
+    T* begin() const { return m_data; }
+    T* end() const { return m_data + m_size; }
+
+private:
+    T* m_data = nullptr;
+    std::size_t m_size = 0;
+};
+
+// Engine state buffer: owns a units_vector, or borrows caller memory after adopt(). The
+// caller keeps borrowed memory alive for as long as the array refers to it. Copies always
+// own their storage (a copied engine never aliases the original's buffers).
+template <typename T>
+class units_array {
+public:
+    units_array() = default;
+    units_array(const units_array& other) : m_storage(other.begin(), other.end()) { own(); }
+    units_array(units_array&& other) noexcept
+        : m_storage(std::move(other.m_storage)), m_data(other.m_data), m_size(other.m_size)
+    {
+        other.m_data = nullptr;
+        other.m_size = 0;
+    }
+    units_array& operator=(const units_array& other)
+    {
+        if (this != &other) {
+            if (m_data != m_storage.data() || m_size != other.m_size) {
+                m_storage.assign(other.begin(), other.end());
+                own();
+            } else {
+                std::copy(other.begin(), other.end(), m_data);
+            }
+        }
+        return *this;
+    }
+    units_array& operator=(units_array&& other) noexcept
+    {
+        if (this != &other) {
+            m_storage = std::move(other.m_storage);
+            m_data = other.m_data;
+            m_size = other.m_size;
+            other.m_data = nullptr;
+            other.m_size = 0;
+        }
+        return *this;
+    }
+
+    // Replaces the contents with n copies of value in fresh owned storage (see units_first_touch)
+    void first_touch(std::size_t n, const T& value);
+    // Refers to [data, data + n) from now on; the owned storage is released
+    void adopt(T* data, std::size_t n)
+    {
+        units_vector<T>().swap(m_storage);
+        m_data = data;
+        m_size = n;
+    }
+    bool owned() const { return m_data == m_storage.data(); }
+
+    T* data() { return m_data; }
+    const T* data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+    T& operator[](std::size_t i) { return m_data[i]; }
+    const T& operator[](std::size_t i) const { return m_data[i]; }
+    T* begin() { return m_data; }
+    const T* begin() const { return m_data; }
+    T* end() { return m_data + m_size; }
+    const T* end() const { return m_data + m_size; }
+
+private:
+    void own()
+    {
+        m_data = m_storage.data();
+        m_size = m_storage.size();
+    }
+
+    units_vector<T> m_storage;
+    T* m_data = nullptr;
+    std::size_t m_size = 0;
+};
+
+template <typename T>
+void units_array<T>::first_touch(std::size_t n, const T& value)
+{
+    units_first_touch(m_storage, n, value);
+    own();
+}
+
+template <typename T>
+void units_first_touch(units_array<T>& a, std::size_t n, const T& value)
+{
+    a.first_touch(n, value);
+}
+
+// Pages of [data, data + bytes) resident on each NUMA node (index = node id). Empty when the
+// placement cannot be queried (not Linux, or the move_pages syscall is unavailable).
+std::vector<std::size_t> units_numa_pages_per_node(const void* data, std::size_t bytes);
+
+// CPUs in the process's affinity mask (taskset, cgroup cpusets), ascending; empty where it
+// cannot be queried (not Linux)
+std::vector<int> units_allowed_cpus();
+
+// Pins the calling thread to cpus[slot % cpus.size()], the one pinning policy shared by the
+// OpenMP threads and UnitsThreadPool workers. Returns false if cpus is empty or the kernel
+// refuses the affinity.
+bool units_pin_current_thread(const std::vector<int>& cpus, int slot);
+
+// Pins each OpenMP thread to one CPU of the process's affinity mask (thread t to the t-th
+// allowed CPU). Returns false when unsupported or when any thread could not be pinned.
+// Threads keep their CPU across parallel regions of the same size, so pages first-touched by
+// a thread stay local to it.
+bool units_pin_openmp_threads();
+
+#endif // UNITS_BUFFER_H
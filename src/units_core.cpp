@@ -3,37 +3,163 @@
 #include <numeric>
 #include <cmath>
 #include <stdexcept>
+#include <chrono>
+#include <cstring>
+#include <string>
 
 #ifdef _OPENMP
 #include <omp.h>
 #endif
 
-UnitsCore::UnitsCore(int width, int height, units_real max_value, bool torus)
+#if defined(USE_SIMD)
+#include "units_simd.h"
+#endif
+
+#include "units_stencil.h"
+#include "units_trace.h"
+
+namespace {
+
+using units_stencil::for_each_moore_neighbor;
+using units_stencil::moore_degree;
+
+// FNV-1a over 64-bit words (a zero-padded tail word for sizes that are not a multiple of 8)
+inline std::uint64_t hash_bytes(std::uint64_t h, const void* data, std::size_t bytes)
+{
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (; bytes > 0; p += 8) {
+        std::uint64_t word = 0;
+        const std::size_t n = bytes < 8 ? bytes : 8;
+        std::memcpy(&word, p, n);
+        h = (h ^ word) * 1099511628211ull;
+        bytes -= n;
+    }
+    return h;
+}
+
+// update() body; clearing and the norm reduction are template flags so that each variant is
+// a branch-free, vectorizable loop
+template <bool kClear, bool kNorms, typename Real, typename Compute>
+inline void integrate_loop(Real* values, Real* deltas, Real* delta_steps, const Real* targets,
+                           std::size_t n, Compute max_value, Compute* norms)
+{
+    Compute max_abs = 0.0;
+    Compute sum_sq = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        Compute v = values[i] + delta_steps[i] + deltas[i];
+        if (v > max_value) v = max_value;
+        else if (v < -max_value) v = -max_value;
+        values[i] = v;
+        const Compute d = targets[i] - v;
+        deltas[i] = d;
+        if (kClear) delta_steps[i] = 0.0;
+        if (kNorms) {
+            max_abs = std::max(max_abs, std::abs(d));
+            sum_sq += d * d;
+        }
+    }
+    if (kNorms) {
+        norms[0] = std::max(norms[0], max_abs);
+        norms[1] += sum_sq;
+    }
+}
+
+// Cells per partial norm sum in update(), which keeps float sums of squares short
+constexpr std::size_t kNormBlockCells = 4096;
+
+// Target working set of one step_n() tile (values, deltas, delta_steps of band + halo rows)
+constexpr std::size_t kTemporalTileBytes = std::size_t(1) << 20;
+
+// Per-phase timers of USE_STATS builds. UNITS_STATS_START opens a timer in the enclosing
+// scope and UNITS_STATS_STOP charges the elapsed time and `bytes` to a phase; both compile
+// to nothing otherwise. Phases split inside one parallel region stamp the boundary on
+// thread 0 after a barrier.
+#if defined(USE_STATS)
+using StatsClock = std::chrono::steady_clock;
+
+inline double stats_seconds(StatsClock::time_point start, StatsClock::time_point stop)
+{
+    return std::chrono::duration<double>(stop - start).count();
+}
+
+#define UNITS_STATS_START(name) const StatsClock::time_point name = StatsClock::now()
+#define UNITS_STATS_STOP(phase, name, bytes) \
+    record_phase(phase, stats_seconds(name, StatsClock::now()), static_cast<std::uint64_t>(bytes))
+#else
+#define UNITS_STATS_START(name) ((void)0)
+#define UNITS_STATS_STOP(phase, name, bytes) ((void)0)
+#endif
+
+// Bulk copies behind set_values() / get_values() and friends
+template <typename Real>
+void copy_state_in(UnitsSpan<const Real> src, units_array<Real>& dst, const char* what)
+{
+    if (src.size() != dst.size()) throw std::invalid_argument(std::string(what) + ": span size != grid size");
+    units_parallel_copy(src.data(), dst.data(), dst.size());
+}
+
+template <typename Real>
+void copy_state_out(const units_array<Real>& src, UnitsSpan<Real> dst, const char* what)
+{
+    if (dst.size() != src.size()) throw std::invalid_argument(std::string(what) + ": span size != grid size");
+    units_parallel_copy(src.data(), dst.data(), src.size());
+}
+
+} // namespace
+
+template <typename Real>
+UnitsCoreT<Real>::UnitsCoreT(int width, int height, compute_type max_value, bool torus, NeighborMode neighbor_mode)
+    : UnitsCoreT(nullptr, width, height, max_value, torus, neighbor_mode)
+{
+}
+
+template <typename Real>
+UnitsCoreT<Real>::UnitsCoreT(int width, int height, const UnitsExternalState<Real>& state, compute_type max_value,
+                             bool torus, NeighborMode neighbor_mode)
+    : UnitsCoreT(&state, width, height, max_value, torus, neighbor_mode)
+{
+}
+
+template <typename Real>
+UnitsCoreT<Real>::UnitsCoreT(const UnitsExternalState<Real>* state, int width, int height, compute_type max_value,
+                             bool torus, NeighborMode neighbor_mode)
     : m_width(width),
       m_height(height),
-      m_max_value(max_value)
+      m_max_value(max_value),
+      m_torus(torus),
+      m_neighbor_mode(neighbor_mode),
+      m_push_strategy(default_push_strategy()),
+      m_delta_norms{ 0.0, 0.0 },
+      m_active_threshold(0.0),
+      m_tile_size(0),
+      m_tiles_x(0),
+      m_tiles_y(0),
+      m_step_count(0),
+      m_snapshot_interval(0),
+      m_stats()
 {
     if (width <= 0 || height <= 0) throw std::invalid_argument("width/height must be > 0");
 
     const std::size_t N = static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
-    m_values.assign(N, 0.0);
-    m_targets.assign(N, 0.0);
-    m_deltas.assign(N, 0.0);
-    m_delta_steps.assign(N, 0.0);
+    // Parallel first touch: pages land on the NUMA node of the thread that steps them
+    const Real zero = static_cast<compute_type>(0.0);
+    const UnitsExternalState<Real> external = state ? *state : UnitsExternalState<Real>();
+    if (!external.values) units_first_touch(m_values, N, zero);
+    if (!external.targets) units_first_touch(m_targets, N, zero);
+    if (!external.deltas) units_first_touch(m_deltas, N, zero);
+    if (!external.delta_steps) units_first_touch(m_delta_steps, N, zero);
+    adopt(external);
 
-    m_neighbor_index_start.assign(N + 1, 0); // extra sentinel at end
-    build_neighbors(torus);
+    if (m_neighbor_mode == NeighborMode::Explicit) {
+        units_first_touch(m_neighbor_index_start, N + 1, 0); // extra sentinel at end
+        build_neighbors(torus);
+    }
 
-#if defined(USE_PER_THREAD_ACCUM) && defined(_OPENMP)
-    // Pre-allocate per-thread accumulator buffer
-    // We allocate a single flat buffer of size (num_threads * N)
-    // Each thread gets a slice [thread_id * N, (thread_id + 1) * N)
-    int num_threads = omp_get_max_threads();
-    m_per_thread_accum.assign(static_cast<std::size_t>(num_threads) * N, 0.0);
-#endif
+    reserve_push_scratch();
 }
 
-void UnitsCore::build_neighbors(bool torus)
+template <typename Real>
+void UnitsCoreT<Real>::build_neighbors(bool torus)
 {
     const int W = m_width;
     const int H = m_height;
@@ -43,100 +169,409 @@ void UnitsCore::build_neighbors(bool torus)
     for (int y = 0; y < H; ++y) {
         for (int x = 0; x < W; ++x) {
             std::size_t idx = static_cast<std::size_t>(y) * W + x;
-            int count = 0;
-            for (int dy = -1; dy <= 1; ++dy) {
-                for (int dx = -1; dx <= 1; ++dx) {
-                    if (dx == 0 && dy == 0) continue;
-                    int nx = x + dx;
-                    int ny = y + dy;
-                    if (torus) {
-                        nx = (nx + W) % W;
-                        ny = (ny + H) % H;
-                    } else {
-                        if (nx < 0 || nx >= W || ny < 0 || ny >= H) continue;
-                    }
-                    ++count;
-                }
-            }
+            const int count = moore_degree(x, y, W, H, torus);
             m_neighbor_index_start[idx + 1] = m_neighbor_index_start[idx] + count;
         }
     }
 
-    // allocate flattened neighbor vector
+    // allocate flattened neighbor vector (left unwritten, filled by the row owners below)
     m_neighbors.resize(m_neighbor_index_start[N]);
 
-    // fill neighbors
+    // fill neighbors, with the same row partition as the push loops (first touch)
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
     for (int y = 0; y < H; ++y) {
         for (int x = 0; x < W; ++x) {
             std::size_t idx = static_cast<std::size_t>(y) * W + x;
             int write_pos = m_neighbor_index_start[idx];
-            for (int dy = -1; dy <= 1; ++dy) {
-                for (int dx = -1; dx <= 1; ++dx) {
-                    if (dx == 0 && dy == 0) continue;
-                    int nx = x + dx;
-                    int ny = y + dy;
-                    if (torus) {
-                        nx = (nx + W) % W;
-                        ny = (ny + H) % H;
-                    } else {
-                        if (nx < 0 || nx >= W || ny < 0 || ny >= H) continue;
-                    }
-                    m_neighbors[write_pos++] = ny * W + nx;
-                }
-            }
+            for_each_moore_neighbor(x, y, W, H, torus, [&](int nx, int ny, int) {
+                m_neighbors[write_pos++] = ny * W + nx;
+            });
             // assert write_pos == m_neighbor_index_start[idx+1];
         }
     }
 }
 
-void UnitsCore::set_value(int x, int y, units_real v)
+template <typename Real>
+template <typename Add>
+void UnitsCoreT<Real>::scatter_row(int y, Add&& add) const
+{
+    const int W = m_width;
+    const int H = m_height;
+    const std::size_t row = static_cast<std::size_t>(y) * W;
+
+    if (m_neighbor_mode == NeighborMode::Explicit) {
+        for (std::size_t i = row; i < row + W; ++i) {
+            const int start = m_neighbor_index_start[i];
+            const int end = m_neighbor_index_start[i + 1];
+            const int degree = end - start;
+            if (degree == 0) continue;
+            compute_type delta = m_deltas[i];
+            compute_type contrib = -delta / static_cast<compute_type>(degree); // amount to add to each neighbor
+            for (int ni = start; ni < end; ++ni) {
+                add(static_cast<std::size_t>(m_neighbors[ni]), contrib);
+            }
+        }
+        return;
+    }
+
+    // Stencil mode: border cells (first/last row and column) take the generic path with
+    // wrap-around or clipping; interior cells use fixed offsets with no modulo.
+    auto scatter_border = [&](int x) {
+        const int degree = moore_degree(x, y, W, H, m_torus);
+        if (degree == 0) return;
+        compute_type contrib = -m_deltas[row + x] / static_cast<compute_type>(degree);
+        for_each_moore_neighbor(x, y, W, H, m_torus, [&](int nx, int ny, int) {
+            add(static_cast<std::size_t>(ny) * W + nx, contrib);
+        });
+    };
+
+    if (y == 0 || y == H - 1 || W < 3) {
+        for (int x = 0; x < W; ++x) scatter_border(x);
+        return;
+    }
+
+    scatter_border(0);
+    const std::size_t up = row - W;
+    const std::size_t down = row + W;
+    for (int x = 1; x < W - 1; ++x) {
+        compute_type contrib = -m_deltas[row + x] / static_cast<compute_type>(8);
+        add(up + x - 1, contrib);
+        add(up + x, contrib);
+        add(up + x + 1, contrib);
+        add(row + x - 1, contrib);
+        add(row + x + 1, contrib);
+        add(down + x - 1, contrib);
+        add(down + x, contrib);
+        add(down + x + 1, contrib);
+    }
+    scatter_border(W - 1);
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::integrate_cells(Real* values, Real* deltas, Real* delta_steps, const Real* targets,
+                                       std::size_t n, bool clear_delta_steps, compute_type* norms) const
+{
+#if defined(USE_SIMD)
+    units_simd::integrate(values, deltas, delta_steps, targets, n, m_max_value, clear_delta_steps, norms);
+#else
+    if (clear_delta_steps) {
+        if (norms) integrate_loop<true, true>(values, deltas, delta_steps, targets, n, m_max_value, norms);
+        else integrate_loop<true, false>(values, deltas, delta_steps, targets, n, m_max_value, norms);
+    } else {
+        if (norms) integrate_loop<false, true>(values, deltas, delta_steps, targets, n, m_max_value, norms);
+        else integrate_loop<false, false>(values, deltas, delta_steps, targets, n, m_max_value, norms);
+    }
+#endif
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::integrate_row(int y, bool clear_delta_steps)
+{
+    const std::size_t begin = static_cast<std::size_t>(y) * m_width;
+    integrate_cells(&m_values[begin], &m_deltas[begin], &m_delta_steps[begin], &m_targets[begin],
+                    static_cast<std::size_t>(m_width), clear_delta_steps, nullptr);
+}
+
+template <typename Real>
+typename UnitsCoreT<Real>::compute_type UnitsCoreT<Real>::gather_cell(int x, int y, const Real* const rows[3]) const
+{
+    const int W = m_width;
+    const int H = m_height;
+
+    // The stencil is symmetric, so the sources pushing into (x, y) are exactly its neighbors.
+    // Sum them in ascending global index order to reproduce the serial scatter bit for bit.
+    std::size_t order[8];
+    compute_type contrib[8];
+    int count = 0;
+    for_each_moore_neighbor(x, y, W, H, m_torus, [&](int nx, int ny, int dy) {
+        const std::size_t nb = static_cast<std::size_t>(ny) * W + nx;
+        const int degree = moore_degree(nx, ny, W, H, m_torus);
+        const compute_type c = -rows[dy + 1][nx] / static_cast<compute_type>(degree);
+        int pos = count++;
+        while (pos > 0 && order[pos - 1] > nb) {
+            order[pos] = order[pos - 1];
+            contrib[pos] = contrib[pos - 1];
+            --pos;
+        }
+        order[pos] = nb;
+        contrib[pos] = c;
+    });
+
+    compute_type sum = 0.0;
+    for (int k = 0; k < count; ++k) {
+        sum += contrib[k];
+    }
+    return sum;
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::gather_row(int y, int x_lo, int x_hi, const Real* up, const Real* mid,
+                                  const Real* down, Real* out, bool accumulate) const
+{
+    const int W = m_width;
+    const int H = m_height;
+    const Real* const rows[3] = { up, mid, down };
+
+    // Fast path needs every source to have degree 8 and to lie in ascending index order
+    // without wrap-around: one cell of margin on a torus, two without wiring at the edges.
+    const int margin = m_torus ? 1 : 2;
+    int x_begin = margin;
+    int x_end = W - margin;
+    if (y < margin || y >= H - margin || x_end <= x_begin) {
+        x_begin = x_hi;
+        x_end = x_hi;
+    }
+    x_begin = std::min(std::max(x_begin, x_lo), x_hi);
+    x_end = std::min(std::max(x_end, x_begin), x_hi);
+
+    for (int x = x_lo; x < x_begin; ++x) {
+        const compute_type sum = gather_cell(x, y, rows);
+        out[x] = accumulate ? out[x] + sum : sum;
+    }
+    if (x_end > x_begin) {
+#if defined(USE_SIMD)
+        units_simd::gather_interior(out + x_begin, up + x_begin, mid + x_begin, down + x_begin,
+                                    static_cast<std::size_t>(x_end - x_begin), accumulate);
+#else
+        const compute_type degree = 8;
+        for (int x = x_begin; x < x_end; ++x) {
+            compute_type sum = 0.0;
+            sum += -up[x - 1] / degree;
+            sum += -up[x] / degree;
+            sum += -up[x + 1] / degree;
+            sum += -mid[x - 1] / degree;
+            sum += -mid[x + 1] / degree;
+            sum += -down[x - 1] / degree;
+            sum += -down[x] / degree;
+            sum += -down[x + 1] / degree;
+            out[x] = accumulate ? out[x] + sum : sum;
+        }
+#endif
+    }
+    for (int x = x_end; x < x_hi; ++x) {
+        const compute_type sum = gather_cell(x, y, rows);
+        out[x] = accumulate ? out[x] + sum : sum;
+    }
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::gather_row(int y, int x_lo, int x_hi, bool accumulate)
+{
+    const int W = m_width;
+    const int H = m_height;
+    // Rows outside a non-torus grid are never dereferenced
+    auto delta_row = [&](int ry) -> const Real* {
+        if (m_torus) ry = (ry + H) % H;
+        else if (ry < 0 || ry >= H) return nullptr;
+        return &m_deltas[static_cast<std::size_t>(ry) * W];
+    };
+    gather_row(y, x_lo, x_hi, delta_row(y - 1), delta_row(y), delta_row(y + 1),
+               &m_delta_steps[static_cast<std::size_t>(y) * W], accumulate);
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::set_value(int x, int y, compute_type v)
 {
     if (x < 0 || x >= m_width || y < 0 || y >= m_height) return;
     set_value_index(static_cast<std::size_t>(y) * m_width + x, v);
 }
 
-void UnitsCore::set_value_index(std::size_t idx, units_real v)
+template <typename Real>
+void UnitsCoreT<Real>::set_value_index(std::size_t idx, compute_type v)
 {
     if (idx >= m_values.size()) return;
     m_values[idx] = v;
+    if (active_set_enabled()) {
+        const int x = static_cast<int>(idx % m_width);
+        const int y = static_cast<int>(idx / m_width);
+        m_tile_active[static_cast<std::size_t>(y / m_tile_size) * m_tiles_x + x / m_tile_size] = 1;
+    }
 }
 
-units_real UnitsCore::value_at(int x, int y) const
+template <typename Real>
+void UnitsCoreT<Real>::set_values(UnitsSpan<const Real> values)
 {
-    if (x < 0 || x >= m_width || y < 0 || y >= m_height) return static_cast<units_real>(0.0);
+    copy_state_in(values, m_values, "set_values");
+    mark_all_tiles_active();
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::set_targets(UnitsSpan<const Real> targets)
+{
+    copy_state_in(targets, m_targets, "set_targets");
+    mark_all_tiles_active();
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::set_deltas(UnitsSpan<const Real> deltas)
+{
+    copy_state_in(deltas, m_deltas, "set_deltas");
+    mark_all_tiles_active();
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::get_values(UnitsSpan<Real> out) const
+{
+    copy_state_out(m_values, out, "get_values");
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::get_targets(UnitsSpan<Real> out) const
+{
+    copy_state_out(m_targets, out, "get_targets");
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::get_deltas(UnitsSpan<Real> out) const
+{
+    copy_state_out(m_deltas, out, "get_deltas");
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::adopt(const UnitsExternalState<Real>& state)
+{
+    const std::size_t N = static_cast<std::size_t>(m_width) * static_cast<std::size_t>(m_height);
+    for (const Real* p : { state.values, state.targets, state.deltas, state.delta_steps }) {
+        if (reinterpret_cast<std::uintptr_t>(p) % alignof(Real) != 0) {
+            throw std::invalid_argument("adopt: buffer is not aligned for the element type");
+        }
+    }
+    if (state.values) m_values.adopt(state.values, N);
+    if (state.targets) m_targets.adopt(state.targets, N);
+    if (state.deltas) m_deltas.adopt(state.deltas, N);
+    if (state.delta_steps) m_delta_steps.adopt(state.delta_steps, N);
+    mark_all_tiles_active();
+}
+
+template <typename Real>
+typename UnitsCoreT<Real>::compute_type UnitsCoreT<Real>::value_at(int x, int y) const
+{
+    if (x < 0 || x >= m_width || y < 0 || y >= m_height) return static_cast<compute_type>(0.0);
     return value_at_index(static_cast<std::size_t>(y) * m_width + x);
 }
 
-units_real UnitsCore::value_at_index(std::size_t idx) const
+template <typename Real>
+typename UnitsCoreT<Real>::compute_type UnitsCoreT<Real>::value_at_index(std::size_t idx) const
 {
-    if (idx >= m_values.size()) return static_cast<units_real>(0.0);
+    if (idx >= m_values.size()) return static_cast<compute_type>(0.0);
     return m_values[idx];
 }
 
-void UnitsCore::update()
+template <typename Real>
+void UnitsCoreT<Real>::update()
+{
+    update(nullptr);
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::update(DeltaNorms* norms)
 {
     const std::size_t N = m_values.size();
+    if (active_set_enabled()) mark_all_tiles_active();
+    UNITS_STATS_START(stats_start);
+    double linf = 0.0;
+    double sum_sq = 0.0;
 
-    // Integrate delta_step + delta into values, clamp, and compute new delta
-    // Parallelizable: each index writes to its own slot
+    // Integrate delta_step + delta into values, clamp, and compute new delta.
+    // Parallelizable: each index writes to its own slot; static partition, one kernel call
+    // per thread (per block of cells when the norms are reduced as well)
 #ifdef _OPENMP
-    #pragma omp parallel for schedule(static)
+    #pragma omp parallel reduction(max : linf) reduction(+ : sum_sq)
+#endif
+    {
+        int tid = 0;
+        int num_threads = 1;
+#ifdef _OPENMP
+        tid = omp_get_thread_num();
+        num_threads = omp_get_num_threads();
 #endif
-    for (std::size_t i = 0; i < N; ++i) {
-        units_real v = m_values[i] + m_delta_steps[i] + m_deltas[i];
-        if (v > m_max_value) v = m_max_value;
-        else if (v < -m_max_value) v = -m_max_value;
-        m_values[i] = v;
-        m_deltas[i] = (m_targets[i] - v);
-        m_delta_steps[i] = 0.0; // clear for next push phase
+        const std::size_t begin = N * tid / num_threads;
+        const std::size_t end = N * (tid + 1) / num_threads;
+        UNITS_TRACE_SCOPE("update");
+        if (!norms) {
+            if (end > begin) {
+                integrate_cells(&m_values[begin], &m_deltas[begin], &m_delta_steps[begin], &m_targets[begin],
+                                end - begin, true, nullptr);
+            }
+        } else {
+            for (std::size_t i = begin; i < end; i += kNormBlockCells) {
+                compute_type block[2] = { 0.0, 0.0 };
+                integrate_cells(&m_values[i], &m_deltas[i], &m_delta_steps[i], &m_targets[i],
+                                std::min(kNormBlockCells, end - i), true, block);
+                linf = std::max(linf, static_cast<double>(block[0]));
+                sum_sq += static_cast<double>(block[1]);
+            }
+        }
+    }
+
+    if (norms) {
+        norms->linf = linf;
+        norms->l2 = std::sqrt(sum_sq);
+    }
+    // Reads values, delta_steps, deltas, targets; writes values, deltas, delta_steps
+    UNITS_STATS_STOP(UnitsPhase::Update, stats_start, 7 * N * sizeof(Real));
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::push()
+{
+    switch (m_push_strategy) {
+#ifdef _OPENMP
+    case PushStrategy::PerThreadAccum: push_per_thread_accum(); break;
+    case PushStrategy::HaloPartitioned: push_halo_partitioned(); break;
+#endif
+    case PushStrategy::Gather: push_gather(); break;
+    default: push_atomic(); break;
     }
+#if defined(USE_STATS)
+    ++m_stats.steps;
+#endif
+    count_steps(1);
 }
 
-void UnitsCore::push()
+template <typename Real>
+void UnitsCoreT<Real>::push_gather()
+{
+    // ============================================================================
+    // Destination-centric gather push (deterministic)
+    // ============================================================================
+    // Tradeoff: Every cell reads the deltas of its 8 neighbors and sums their
+    // contributions in ascending source index, the order in which the serial
+    // scatter adds them. Each output is written by exactly one thread, so there
+    // are no atomics and no accumulator buffers, and the result does not depend
+    // on the thread count or schedule. Uses the SIMD kernels with USE_SIMD.
+    //
+    // Heuristic: Reads each delta 8 times (from cache), so it is the fastest
+    // strategy on most hosts; the scatter strategies can win on very narrow grids.
+    // The fixed Moore geometry is computed arithmetically, so the CSR neighbor
+    // arrays of NeighborMode::Explicit are not consulted.
+    // ============================================================================
+
+    UNITS_STATS_START(stats_start);
+#ifdef _OPENMP
+    #pragma omp parallel
+#endif
+    {
+        UNITS_TRACE_SCOPE("gather");
+#ifdef _OPENMP
+        #pragma omp for schedule(static) nowait
+#endif
+        for (int y = 0; y < m_height; ++y) {
+            gather_row(y, true);
+        }
+    }
+    // Reads deltas, accumulates into delta_steps
+    UNITS_STATS_STOP(UnitsPhase::Gather, stats_start, 3 * m_values.size() * sizeof(Real));
+}
+
+#ifdef _OPENMP
+template <typename Real>
+void UnitsCoreT<Real>::push_per_thread_accum()
 {
     const std::size_t N = m_values.size();
 
-#if defined(USE_PER_THREAD_ACCUM) && defined(_OPENMP)
     // ============================================================================
     // Per-thread accumulator push algorithm (source-centric)
     // ============================================================================
@@ -150,53 +585,169 @@ void UnitsCore::push()
     // cache locality and less memory bandwidth usage.
     //
     // Memory: Allocates (num_threads * N) buffer. For 1024x1024 grid with 16 threads
-    // and float, this is ~64MB. Pre-allocated in constructor to avoid per-step overhead.
+    // and float, this is ~64MB. Allocated with the strategy and reused for later steps.
     // ============================================================================
 
     const int num_threads = omp_get_max_threads();
+    const std::size_t needed = static_cast<std::size_t>(num_threads) * N;
+    if (m_per_thread_accum.size() < needed) units_first_touch(m_per_thread_accum, needed, compute_type(0.0));
+
+    UNITS_STATS_START(stats_start);
+#if defined(USE_STATS)
+    StatsClock::time_point stats_zeroed = stats_start;
+#endif
 
     // Phase 1: Each thread accumulates into its own slice of m_per_thread_accum
     #pragma omp parallel
     {
         const int tid = omp_get_thread_num();
-        units_real* thread_accum = &m_per_thread_accum[static_cast<std::size_t>(tid) * N];
+        compute_type* thread_accum = &m_per_thread_accum[static_cast<std::size_t>(tid) * N];
 
         // Zero out this thread's accumulator slice
-        for (std::size_t i = 0; i < N; ++i) {
-            thread_accum[i] = 0.0;
+        {
+            UNITS_TRACE_SCOPE("zero");
+            for (std::size_t i = 0; i < N; ++i) {
+                thread_accum[i] = 0.0;
+            }
         }
+#if defined(USE_STATS)
+        #pragma omp barrier
+        if (tid == 0) stats_zeroed = StatsClock::now();
+#endif
 
-        // Source-centric: each thread processes a subset of source cells
+        // Source-centric: each thread processes a subset of source rows
+        UNITS_TRACE_SCOPE("scatter");
         #pragma omp for schedule(static) nowait
-        for (std::size_t i = 0; i < N; ++i) {
-            const int start = m_neighbor_index_start[i];
-            const int end = m_neighbor_index_start[i + 1];
-            const int degree = end - start;
-            if (degree == 0) continue;
-
-            units_real delta = m_deltas[i];
-            units_real contrib = -delta / static_cast<units_real>(degree);
-
+        for (int y = 0; y < m_height; ++y) {
             // Accumulate to neighbors in this thread's local buffer
-            for (int ni = start; ni < end; ++ni) {
-                std::size_t nb = static_cast<std::size_t>(m_neighbors[ni]);
+            scatter_row(y, [thread_accum](std::size_t nb, compute_type contrib) {
                 thread_accum[nb] += contrib;
-            }
+            });
         }
     }
 
+#if defined(USE_STATS)
+    const std::size_t accum_bytes = static_cast<std::size_t>(num_threads) * N * sizeof(compute_type);
+    record_phase(UnitsPhase::Zero, stats_seconds(stats_start, stats_zeroed), accum_bytes);
+    // Reads deltas (and the neighbor lists); each destination is updated in about one
+    // thread's accumulator (its band plus the rows around it)
+    record_phase(UnitsPhase::Scatter, stats_seconds(stats_zeroed, StatsClock::now()),
+                 N * sizeof(Real) + 2 * N * sizeof(compute_type) + (m_neighbor_index_start.size() + m_neighbors.size()) * sizeof(int));
+    UNITS_STATS_START(stats_merge);
+#endif
+
     // Phase 2: Merge all per-thread accumulators into m_delta_steps
     // Each output cell is written by exactly one thread, so no atomics needed
-    #pragma omp parallel for schedule(static)
-    for (std::size_t i = 0; i < N; ++i) {
-        units_real sum = 0.0;
-        for (int tid = 0; tid < num_threads; ++tid) {
-            sum += m_per_thread_accum[static_cast<std::size_t>(tid) * N + i];
+    #pragma omp parallel
+    {
+        UNITS_TRACE_SCOPE("merge");
+        #pragma omp for schedule(static) nowait
+        for (std::size_t i = 0; i < N; ++i) {
+            compute_type sum = 0.0;
+            for (int tid = 0; tid < num_threads; ++tid) {
+                sum += m_per_thread_accum[static_cast<std::size_t>(tid) * N + i];
+            }
+            m_delta_steps[i] += sum;
         }
-        m_delta_steps[i] += sum;
     }
+    UNITS_STATS_STOP(UnitsPhase::Merge, stats_merge, accum_bytes + 2 * N * sizeof(Real));
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::push_halo_partitioned()
+{
+    // ============================================================================
+    // Halo-partitioned push algorithm (row bands with private halo rows)
+    // ============================================================================
+    // Tradeoff: Each thread owns a contiguous band of rows and scatters straight into
+    // m_delta_steps for destinations inside its band. Only contributions that leave the
+    // band (the row just above and just below it) go to a private halo buffer, which is
+    // merged after a barrier. No atomics, no zeroing of N-sized buffers.
+    //
+    // Heuristic: Scales with thread count since per-thread work and memory do not grow
+    // with N * threads. Needs bands of a few rows to amortize the halo merge, i.e. it is
+    // best when height >> threads.
+    //
+    // Memory: (num_threads * 2 * width) accumulators, e.g. 1.5 MB for 96 threads at width
+    // 1024 in double.
+    // ============================================================================
+
+    const int W = m_width;
+    const int H = m_height;
+    const std::size_t halo_stride = 2 * static_cast<std::size_t>(W);
+    const std::size_t needed = static_cast<std::size_t>(omp_get_max_threads()) * halo_stride;
+    if (m_halo_accum.size() < needed) units_first_touch(m_halo_accum, needed, compute_type(0.0));
+
+    UNITS_STATS_START(stats_start);
+#if defined(USE_STATS)
+    StatsClock::time_point stats_scattered = stats_start;
+#endif
+
+    #pragma omp parallel
+    {
+        const int tid = omp_get_thread_num();
+        const int num_threads = omp_get_num_threads();
+        const int y_begin = static_cast<int>(static_cast<long long>(H) * tid / num_threads);
+        const int y_end = static_cast<int>(static_cast<long long>(H) * (tid + 1) / num_threads);
+
+        compute_type* halo_top = &m_halo_accum[static_cast<std::size_t>(tid) * halo_stride];
+        compute_type* halo_bottom = halo_top + W;
+        std::fill(halo_top, halo_top + halo_stride, static_cast<compute_type>(0.0));
+
+        // Rows just outside the band (only reachable on a torus when they wrap)
+        const int top_row = m_torus ? (y_begin - 1 + H) % H : y_begin - 1;
+        const int bottom_row = m_torus ? y_end % H : y_end;
+        const std::size_t band_lo = static_cast<std::size_t>(y_begin) * W;
+        const std::size_t band_hi = static_cast<std::size_t>(y_end) * W;
+        const std::size_t top_lo = static_cast<std::size_t>(top_row < 0 ? 0 : top_row) * W;
+        const std::size_t bottom_lo = static_cast<std::size_t>(bottom_row) * W;
+        Real* delta_steps = m_delta_steps.data();
+
+        {
+            UNITS_TRACE_SCOPE("scatter");
+            for (int y = y_begin; y < y_end; ++y) {
+                scatter_row(y, [&](std::size_t nb, compute_type contrib) {
+                    if (nb >= band_lo && nb < band_hi) delta_steps[nb] += contrib;
+                    else if (nb >= top_lo && nb < top_lo + W) halo_top[nb - top_lo] += contrib;
+                    else halo_bottom[nb - bottom_lo] += contrib;
+                });
+            }
+        }
+
+        // Merge halos into the neighboring bands. Tops and bottoms are merged in separate
+        // rounds, since a one-row band is both the top and the bottom halo of other threads.
+        #pragma omp barrier
+#if defined(USE_STATS)
+        if (tid == 0) stats_scattered = StatsClock::now();
+#endif
+        if (y_end > y_begin && top_row >= 0) {
+            UNITS_TRACE_SCOPE("merge");
+            for (int x = 0; x < W; ++x) delta_steps[top_lo + x] += halo_top[x];
+        }
+        #pragma omp barrier
+        if (y_end > y_begin && bottom_row < H) {
+            UNITS_TRACE_SCOPE("merge");
+            for (int x = 0; x < W; ++x) delta_steps[bottom_lo + x] += halo_bottom[x];
+        }
+    }
+
+#if defined(USE_STATS)
+    const std::size_t N = m_values.size();
+    const std::size_t halo_bytes = needed * sizeof(compute_type);
+    // Reads deltas (and the neighbor lists), updates delta_steps in place and the halo rows
+    record_phase(UnitsPhase::Scatter, stats_seconds(stats_start, stats_scattered),
+                 3 * N * sizeof(Real) + halo_bytes + (m_neighbor_index_start.size() + m_neighbors.size()) * sizeof(int));
+    record_phase(UnitsPhase::Merge, stats_seconds(stats_scattered, StatsClock::now()),
+                 halo_bytes + 2 * needed * sizeof(Real));
+#endif
+}
+#endif
+
+template <typename Real>
+void UnitsCoreT<Real>::push_atomic()
+{
+    const std::size_t N = m_values.size();
 
-#else
     // ============================================================================
     // Destination-centric push algorithm with atomic accumulation (or serial fallback)
     // ============================================================================
@@ -204,51 +755,689 @@ void UnitsCore::push()
     // memory-efficient (only one temporary buffer of size N). Good cache locality
     // since we write to destinations that might be cached by other threads.
     //
-    // Heuristic: Preferred for smaller grids (<512x512) or when OpenMP is not
-    // available or when USE_PER_THREAD_ACCUM is not enabled. Atomic overhead is
-    // acceptable when the number of concurrent writes to the same location is low.
+    // Heuristic: Preferred for smaller grids (<512x512) or few threads. Also the
+    // serial fallback for every strategy when OpenMP is not available. Atomic overhead
+    // is acceptable when the number of concurrent writes to the same location is low.
     // ============================================================================
 
-    // To enable safe parallelization we will accumulate contributions into a temporary buffer
+    // To enable safe parallelization we accumulate contributions into a persistent buffer
     // then apply them to m_delta_steps. This avoids simultaneous writes to the same slot.
-    std::vector<units_real> accum(N, 0.0);
+    // The buffer is zeroed while it is applied, ready for the next step.
+    if (m_push_accum.size() != N) units_first_touch(m_push_accum, N, compute_type(0.0));
 
+    compute_type* accum_data = m_push_accum.data();
+    Real* delta_steps = m_delta_steps.data();
+    const std::ptrdiff_t n = static_cast<std::ptrdiff_t>(N);
+    UNITS_STATS_START(stats_start);
+#if defined(USE_STATS)
+    StatsClock::time_point stats_scattered = stats_start;
+#endif
 #ifdef _OPENMP
     #pragma omp parallel
     {
-        #pragma omp for schedule(static)
-        for (std::size_t i = 0; i < N; ++i) {
-            const int start = m_neighbor_index_start[i];
-            const int end = m_neighbor_index_start[i + 1];
-            const int degree = end - start;
-            if (degree == 0) continue;
-            units_real delta = m_deltas[i];
-            units_real contrib = -delta / static_cast<units_real>(degree); // amount to add to each neighbor
-            for (int ni = start; ni < end; ++ni) {
-                std::size_t nb = static_cast<std::size_t>(m_neighbors[ni]);
-                #pragma omp atomic
-                accum[nb] += contrib;
+        {
+            UNITS_TRACE_SCOPE("scatter");
+            #pragma omp for schedule(static) nowait
+            for (int y = 0; y < m_height; ++y) {
+                scatter_row(y, [accum_data](std::size_t nb, compute_type contrib) {
+                    #pragma omp atomic
+                    accum_data[nb] += contrib;
+                });
             }
         }
+        #pragma omp barrier
+#if defined(USE_STATS)
+        if (omp_get_thread_num() == 0) stats_scattered = StatsClock::now();
+#endif
+
+        // Apply accumulation to delta_steps (after the barrier above)
+        UNITS_TRACE_SCOPE("apply");
+        #pragma omp for schedule(static) nowait
+        for (std::ptrdiff_t i = 0; i < n; ++i) {
+            delta_steps[i] += accum_data[i];
+            accum_data[i] = 0.0;
+        }
     }
 #else
-    for (std::size_t i = 0; i < N; ++i) {
-        const int start = m_neighbor_index_start[i];
-        const int end = m_neighbor_index_start[i + 1];
-        const int degree = end - start;
-        if (degree == 0) continue;
-        units_real delta = m_deltas[i];
-        units_real contrib = -delta / static_cast<units_real>(degree);
-        for (int ni = start; ni < end; ++ni) {
-            std::size_t nb = static_cast<std::size_t>(m_neighbors[ni]);
-            accum[nb] += contrib;
-        }
+    for (int y = 0; y < m_height; ++y) {
+        scatter_row(y, [accum_data](std::size_t nb, compute_type contrib) {
+            accum_data[nb] += contrib;
+        });
     }
+#if defined(USE_STATS)
+    stats_scattered = StatsClock::now();
 #endif
 
     // Apply accumulation to delta_steps
-    for (std::size_t i = 0; i < N; ++i) {
-        m_delta_steps[i] += accum[i];
+    for (std::ptrdiff_t i = 0; i < n; ++i) {
+        delta_steps[i] += accum_data[i];
+        accum_data[i] = 0.0;
+    }
+#endif
+
+#if defined(USE_STATS)
+    const std::size_t accum_bytes = N * sizeof(compute_type);
+    // Reads deltas (and the neighbor lists), updates the shared accumulator
+    record_phase(UnitsPhase::Scatter, stats_seconds(stats_start, stats_scattered),
+                 N * sizeof(Real) + 2 * accum_bytes + (m_neighbor_index_start.size() + m_neighbors.size()) * sizeof(int));
+    // Reads and clears the accumulator, updates delta_steps
+    record_phase(UnitsPhase::Merge, stats_seconds(stats_scattered, StatsClock::now()),
+                 2 * accum_bytes + 2 * N * sizeof(Real));
+#endif
+}
+
+template <typename Real>
+UnitsPushStrategy UnitsCoreT<Real>::default_push_strategy()
+{
+#if defined(USE_PER_THREAD_ACCUM) && defined(_OPENMP)
+    return PushStrategy::PerThreadAccum;
+#elif defined(USE_HALO_PUSH) && defined(_OPENMP)
+    return PushStrategy::HaloPartitioned;
+#elif defined(USE_SIMD)
+    return PushStrategy::Gather; // the push kernels of USE_SIMD are gathers
+#else
+    return PushStrategy::Atomic;
+#endif
+}
+
+template <typename Real>
+std::vector<UnitsPushStrategy> UnitsCoreT<Real>::available_push_strategies()
+{
+#ifdef _OPENMP
+    return { PushStrategy::Atomic, PushStrategy::PerThreadAccum, PushStrategy::HaloPartitioned,
+             PushStrategy::Gather };
+#else
+    return { PushStrategy::Atomic, PushStrategy::Gather };
+#endif
+}
+
+template <typename Real>
+const char* UnitsCoreT<Real>::push_strategy_name(PushStrategy strategy)
+{
+    switch (strategy) {
+    case PushStrategy::Atomic: return "atomic";
+    case PushStrategy::PerThreadAccum: return "per_thread_accum";
+    case PushStrategy::HaloPartitioned: return "halo";
+    case PushStrategy::Gather: return "gather";
+    }
+    return "unknown";
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::set_push_strategy(PushStrategy strategy)
+{
+    const std::vector<PushStrategy> available = available_push_strategies();
+    if (std::find(available.begin(), available.end(), strategy) == available.end()) {
+        throw std::invalid_argument("push strategy not available in this build (requires OpenMP)");
+    }
+    m_push_strategy = strategy;
+    reserve_push_scratch();
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::reserve_push_scratch()
+{
+    const std::size_t N = m_values.size();
+    int max_threads = 1;
+#ifdef _OPENMP
+    max_threads = omp_get_max_threads();
+#endif
+
+    switch (m_push_strategy) {
+    case PushStrategy::Atomic:
+        if (m_push_accum.size() != N) units_first_touch(m_push_accum, N, compute_type(0.0));
+        break;
+    case PushStrategy::PerThreadAccum:
+        if (m_per_thread_accum.size() < static_cast<std::size_t>(max_threads) * N) {
+            units_first_touch(m_per_thread_accum, static_cast<std::size_t>(max_threads) * N, compute_type(0.0));
+        }
+        break;
+    case PushStrategy::HaloPartitioned:
+        if (m_halo_accum.size() < static_cast<std::size_t>(max_threads) * 2 * m_width) {
+            units_first_touch(m_halo_accum, static_cast<std::size_t>(max_threads) * 2 * m_width, compute_type(0.0));
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+template <typename Real>
+std::vector<UnitsPushTiming> UnitsCoreT<Real>::autotune(int steps)
+{
+    if (steps <= 0) throw std::invalid_argument("autotune: steps must be > 0");
+
+    // Time whole steps on the real grid and thread count, then roll the state back so
+    // tuning has no effect on the simulation.
+    const units_vector<Real> values(m_values.begin(), m_values.end());
+    const units_vector<Real> deltas(m_deltas.begin(), m_deltas.end());
+    const units_vector<Real> delta_steps(m_delta_steps.begin(), m_delta_steps.end());
+    const UnitsStats stats = m_stats;
+    const std::uint64_t step_count = m_step_count;
+    const int snapshot_interval = m_snapshot_interval;
+    m_snapshot_interval = 0; // trial states are never published
+
+    std::vector<PushTiming> timings;
+    for (PushStrategy strategy : available_push_strategies()) {
+        m_push_strategy = strategy;
+        // Dense steps (step() may take the active-set path, which does not push)
+        update(); // warm up: allocates the strategy's scratch buffers, faults in pages
+        push();
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < steps; ++i) {
+            update();
+            push();
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        timings.push_back({ strategy, elapsed.count() / steps });
+
+        std::copy(values.begin(), values.end(), m_values.begin());
+        std::copy(deltas.begin(), deltas.end(), m_deltas.begin());
+        std::copy(delta_steps.begin(), delta_steps.end(), m_delta_steps.begin());
+    }
+
+    const auto best = std::min_element(timings.begin(), timings.end(),
+        [](const PushTiming& a, const PushTiming& b) { return a.seconds_per_step < b.seconds_per_step; });
+    m_push_strategy = best->strategy;
+    m_stats = stats; // the trial steps are not part of the run
+    m_step_count = step_count;
+    m_snapshot_interval = snapshot_interval;
+
+    // Drop the scratch of the strategies that lost (per-thread accumulators are threads * N)
+    if (m_push_strategy != PushStrategy::Atomic) units_vector<compute_type>().swap(m_push_accum);
+    if (m_push_strategy != PushStrategy::PerThreadAccum) units_vector<compute_type>().swap(m_per_thread_accum);
+    if (m_push_strategy != PushStrategy::HaloPartitioned) units_vector<compute_type>().swap(m_halo_accum);
+    return timings;
+}
+
+template <typename Real>
+const char* UnitsCoreT<Real>::simd_isa()
+{
+#if defined(USE_SIMD)
+    return units_simd::isa_name(units_simd::active_isa());
+#else
+    return "disabled";
+#endif
+}
+
+template <typename Real>
+std::uint64_t UnitsCoreT<Real>::state_hash() const
+{
+    const std::size_t bytes = m_values.size() * sizeof(Real);
+    std::uint64_t h = 1469598103934665603ull;
+    h = hash_bytes(h, m_values.data(), bytes);
+    h = hash_bytes(h, m_deltas.data(), bytes);
+    h = hash_bytes(h, m_delta_steps.data(), bytes);
+    return h;
+}
+
+template <typename Real>
+const char* UnitsCoreT<Real>::phase_name(UnitsPhase phase)
+{
+    switch (phase) {
+    case UnitsPhase::Update: return "update";
+    case UnitsPhase::Scatter: return "scatter";
+    case UnitsPhase::Zero: return "zero";
+    case UnitsPhase::Merge: return "merge";
+    case UnitsPhase::Gather: return "gather";
+    case UnitsPhase::Fused: return "fused";
+    case UnitsPhase::Temporal: return "temporal";
+    case UnitsPhase::Active: return "active";
+    case UnitsPhase::Pooled: return "pooled";
+    default: return "unknown";
+    }
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::record_phase(UnitsPhase phase, double seconds, std::uint64_t bytes)
+{
+    UnitsPhaseStats& s = m_stats.phases[static_cast<int>(phase)];
+    s.seconds += seconds;
+    ++s.calls;
+    s.bytes += bytes;
+}
+
+template <typename Real>
+std::vector<std::size_t> UnitsCoreT<Real>::numa_pages_per_node() const
+{
+    std::vector<std::size_t> total;
+    for (const units_array<Real>* buffer : { &m_values, &m_targets, &m_deltas, &m_delta_steps }) {
+        const std::vector<std::size_t> pages = units_numa_pages_per_node(buffer->data(), buffer->size() * sizeof(Real));
+        if (pages.empty()) return {};
+        if (total.size() < pages.size()) total.resize(pages.size(), 0);
+        for (std::size_t node = 0; node < pages.size(); ++node) total[node] += pages[node];
+    }
+    return total;
+}
+
+template <typename Real>
+int UnitsCoreT<Real>::step_until(compute_type epsilon, int max_steps)
+{
+    if (max_steps < 0) throw std::invalid_argument("step_until: max_steps must be >= 0");
+
+    int steps = 0;
+    while (steps < max_steps) {
+        update(&m_delta_norms);
+        push();
+        ++steps;
+        if (m_delta_norms.linf <= epsilon) break;
+    }
+    return steps;
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::step_fused()
+{
+    const int H = m_height;
+    if (active_set_enabled()) mark_all_tiles_active();
+    UNITS_STATS_START(stats_start);
+
+    // Each thread owns a contiguous band of rows. Rows are integrated top to bottom and
+    // row y - 1 is gathered right after row y, while its neighborhood is still in cache.
+    // The first and last row of a band depend on the adjacent bands, so they are gathered
+    // after a single barrier.
+#ifdef _OPENMP
+    #pragma omp parallel
+#endif
+    {
+        int tid = 0;
+        int num_threads = 1;
+#ifdef _OPENMP
+        tid = omp_get_thread_num();
+        num_threads = omp_get_num_threads();
+#endif
+        const int y_begin = static_cast<int>(static_cast<long long>(H) * tid / num_threads);
+        const int y_end = static_cast<int>(static_cast<long long>(H) * (tid + 1) / num_threads);
+
+        {
+            UNITS_TRACE_SCOPE("fused");
+            for (int y = y_begin; y < y_end; ++y) {
+                integrate_row(y, false);
+                if (y - 1 > y_begin) gather_row(y - 1, false);
+            }
+        }
+
+#ifdef _OPENMP
+        #pragma omp barrier
+#endif
+        if (y_end > y_begin) {
+            UNITS_TRACE_SCOPE("fused_edges");
+            gather_row(y_begin, false);
+            if (y_end - 1 > y_begin) gather_row(y_end - 1, false);
+        }
+    }
+    // Same arrays as update(); the gather reuses the cached deltas and overwrites delta_steps
+    UNITS_STATS_STOP(UnitsPhase::Fused, stats_start, 7 * m_values.size() * sizeof(Real));
+#if defined(USE_STATS)
+    ++m_stats.steps;
+#endif
+    count_steps(1);
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::step_n(int k)
+{
+    if (k < 0) throw std::invalid_argument("step_n: k must be >= 0");
+    if (k == 0) return;
+    if (k == 1) {
+        step_fused();
+        return;
     }
+    UNITS_STATS_START(stats_start);
+
+    const int W = m_width;
+    const int H = m_height;
+    const std::size_t row_cells = static_cast<std::size_t>(W);
+    if (active_set_enabled()) mark_all_tiles_active();
+
+    // Band height: as many rows as fit the tile budget next to the 2k halo rows, but at least
+    // 2k so the redundant halo work stays below ~50%.
+    const std::size_t row_bytes = 3 * row_cells * sizeof(Real);
+    const int budget_rows = static_cast<int>(std::min<std::size_t>(kTemporalTileBytes / row_bytes, H));
+    const int band_rows = std::max(budget_rows - 2 * k, 2 * k);
+    const int num_bands = std::max(1, H / band_rows);
+    const int max_band_rows = (H + num_bands - 1) / num_bands;
+
+    auto band_begin = [H, num_bands](int b) {
+        return static_cast<int>(static_cast<long long>(H) * b / num_bands);
+    };
+    auto wrap_row = [H](int y) { return ((y % H) + H) % H; };
+
+    // Phase 1: copy every band's halo rows (k above, k below) at the starting time level,
+    // since neighboring bands overwrite them in phase 2. Layout per band:
+    // [values | deltas | delta_steps] x [k rows above, k rows below] x W.
+    const std::size_t halo_cells = 2 * static_cast<std::size_t>(k) * row_cells;
+    const std::size_t halo_stride = 3 * halo_cells;
+    if (m_halo_scratch.size() < halo_stride * num_bands) m_halo_scratch.resize(halo_stride * num_bands);
+
+    int max_threads = 1;
+#ifdef _OPENMP
+    max_threads = omp_get_max_threads();
+#endif
+    const int max_tile_rows = max_band_rows + 2 * k;
+    const std::size_t tile_cells = static_cast<std::size_t>(max_tile_rows) * row_cells;
+    const std::size_t tile_stride = 3 * tile_cells;
+    if (m_tile_scratch.size() < tile_stride * max_threads) m_tile_scratch.resize(tile_stride * max_threads);
+
+#ifdef _OPENMP
+    #pragma omp parallel
+#endif
+    {
+#ifdef _OPENMP
+        #pragma omp for schedule(static)
+#endif
+        for (int b = 0; b < num_bands; ++b) {
+            UNITS_TRACE_SCOPE("halo_copy");
+            const int y0 = band_begin(b);
+            const int y1 = band_begin(b + 1);
+            Real* halo = &m_halo_scratch[halo_stride * b];
+            for (int j = 0; j < 2 * k; ++j) {
+                int g = j < k ? y0 - k + j : y1 + (j - k);
+                if (!m_torus && (g < 0 || g >= H)) continue;
+                g = wrap_row(g);
+                const std::size_t src = static_cast<std::size_t>(g) * row_cells;
+                const std::size_t dst = static_cast<std::size_t>(j) * row_cells;
+                std::copy_n(&m_values[src], row_cells, halo + dst);
+                std::copy_n(&m_deltas[src], row_cells, halo + halo_cells + dst);
+                std::copy_n(&m_delta_steps[src], row_cells, halo + 2 * halo_cells + dst);
+            }
+        }
+
+        // Phase 2: each band is loaded with its halo into a thread-private tile and advanced
+        // k steps. The valid region shrinks by one row per step on every side that borders
+        // halo data (not on the physical edges of a non-torus grid).
+        int tid = 0;
+#ifdef _OPENMP
+        tid = omp_get_thread_num();
+#endif
+        Real* tv = &m_tile_scratch[tile_stride * tid];
+        Real* td = tv + tile_cells;
+        Real* tds = td + tile_cells;
+
+#ifdef _OPENMP
+        #pragma omp for schedule(dynamic, 1)
+#endif
+        for (int b = 0; b < num_bands; ++b) {
+            UNITS_TRACE_SCOPE("temporal_band");
+            const int y0 = band_begin(b);
+            const int y1 = band_begin(b + 1);
+            const int top = m_torus ? k : std::min(k, y0);
+            const int bottom = m_torus ? k : std::min(k, H - y1);
+            const int rows = top + (y1 - y0) + bottom;
+            const int first = y0 - top; // unwrapped global row of tile row 0
+            const Real* halo = &m_halo_scratch[halo_stride * b];
+
+            for (int j = 0; j < rows; ++j) {
+                const std::size_t dst = static_cast<std::size_t>(j) * row_cells;
+                if (j >= top && j < top + (y1 - y0)) {
+                    const std::size_t src = static_cast<std::size_t>(first + j) * row_cells;
+                    std::copy_n(&m_values[src], row_cells, tv + dst);
+                    std::copy_n(&m_deltas[src], row_cells, td + dst);
+                    std::copy_n(&m_delta_steps[src], row_cells, tds + dst);
+                } else {
+                    const int slot = j < top ? k - top + j : k + (j - top - (y1 - y0));
+                    const std::size_t src = static_cast<std::size_t>(slot) * row_cells;
+                    std::copy_n(halo + src, row_cells, tv + dst);
+                    std::copy_n(halo + halo_cells + src, row_cells, td + dst);
+                    std::copy_n(halo + 2 * halo_cells + src, row_cells, tds + dst);
+                }
+            }
+
+            const bool shrink_top = m_torus || first > 0;
+            const bool shrink_bottom = m_torus || first + rows < H;
+            int lo = 0;
+            int hi = rows;
+            for (int step = 0; step < k; ++step) {
+                for (int j = lo; j < hi; ++j) {
+                    const std::size_t off = static_cast<std::size_t>(j) * row_cells;
+                    const Real* targets = &m_targets[static_cast<std::size_t>(wrap_row(first + j)) * row_cells];
+                    integrate_cells(tv + off, td + off, tds + off, targets, row_cells, false, nullptr);
+                }
+                if (shrink_top) ++lo;
+                if (shrink_bottom) --hi;
+                for (int j = lo; j < hi; ++j) {
+                    const std::size_t off = static_cast<std::size_t>(j) * row_cells;
+                    const Real* up = j > 0 ? td + off - row_cells : nullptr;
+                    const Real* down = j + 1 < rows ? td + off + row_cells : nullptr;
+                    gather_row(wrap_row(first + j), 0, W, up, td + off, down, tds + off, false);
+                }
+            }
+
+            const std::size_t src = static_cast<std::size_t>(top) * row_cells;
+            const std::size_t dst = static_cast<std::size_t>(y0) * row_cells;
+            const std::size_t count = static_cast<std::size_t>(y1 - y0) * row_cells;
+            std::copy_n(tv + src, count, &m_values[dst]);
+            std::copy_n(td + src, count, &m_deltas[dst]);
+            std::copy_n(tds + src, count, &m_delta_steps[dst]);
+        }
+    }
+    // Each band is read and written back once for all k steps (halo rows are re-read)
+    UNITS_STATS_STOP(UnitsPhase::Temporal, stats_start, 7 * m_values.size() * sizeof(Real));
+#if defined(USE_STATS)
+    m_stats.steps += static_cast<std::uint64_t>(k);
 #endif
-}
\ No newline at end of file
+    count_steps(static_cast<std::uint64_t>(k));
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::step_many(int count)
+{
+    if (count < 0) throw std::invalid_argument("step_many: count must be >= 0");
+    if (count == 0) return;
+
+    if (m_thread_pool && !active_set_enabled()) {
+        step_pooled(count);
+        return;
+    }
+    for (int i = 0; i < count; ++i) step();
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::enable_snapshots(int interval)
+{
+    m_snapshot_interval = std::max(interval, 0);
+    m_snapshots.resize(interval > 0 ? m_values.size() : 0);
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::publish_snapshot()
+{
+    if (m_snapshot_interval <= 0) return;
+    UNITS_TRACE_SCOPE("snapshot");
+    m_snapshots.publish(m_values.data(), m_step_count);
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::count_steps(std::uint64_t count)
+{
+    const std::uint64_t before = m_step_count;
+    m_step_count += count;
+    if (m_snapshot_interval <= 0) return;
+    const std::uint64_t interval = static_cast<std::uint64_t>(m_snapshot_interval);
+    if (m_step_count / interval != before / interval) publish_snapshot();
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::step_pooled(int count)
+{
+    const std::size_t N = m_values.size();
+    const int H = m_height;
+    UnitsThreadPool& pool = *m_thread_pool;
+    UNITS_STATS_START(stats_start);
+
+    // Static partition: cells for the integrate phase, rows for the gather phase. The gather
+    // overwrites every delta_step, so the integrate phase does not clear them.
+    pool.run([&](int tid, int threads) {
+        const std::size_t begin = N * tid / threads;
+        const std::size_t end = N * (tid + 1) / threads;
+        const int y_begin = static_cast<int>(static_cast<long long>(H) * tid / threads);
+        const int y_end = static_cast<int>(static_cast<long long>(H) * (tid + 1) / threads);
+
+        for (int s = 0; s < count; ++s) {
+            if (end > begin) {
+                UNITS_TRACE_SCOPE("integrate");
+                integrate_cells(&m_values[begin], &m_deltas[begin], &m_delta_steps[begin], &m_targets[begin],
+                                end - begin, false, nullptr);
+            }
+            pool.barrier();
+            {
+                UNITS_TRACE_SCOPE("gather");
+                for (int y = y_begin; y < y_end; ++y) {
+                    gather_row(y, false);
+                }
+            }
+            if (s + 1 < count) pool.barrier();
+        }
+    });
+    // Per step: integrate reads four arrays and writes two, the gather reads the deltas back
+    // and overwrites delta_steps
+    UNITS_STATS_STOP(UnitsPhase::Pooled, stats_start, 8 * static_cast<std::uint64_t>(count) * N * sizeof(Real));
+#if defined(USE_STATS)
+    m_stats.steps += static_cast<std::uint64_t>(count);
+#endif
+    count_steps(static_cast<std::uint64_t>(count));
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::set_active_set(compute_type threshold, int tile_size)
+{
+    if (tile_size <= 0) throw std::invalid_argument("set_active_set: tile_size must be > 0");
+
+    m_active_threshold = threshold > 0 ? threshold : 0;
+    if (!active_set_enabled()) {
+        std::vector<unsigned char>().swap(m_tile_active);
+        std::vector<unsigned char>().swap(m_tile_queued);
+        std::vector<int>().swap(m_tile_work);
+        return;
+    }
+
+    m_tile_size = tile_size;
+    m_tiles_x = (m_width + tile_size - 1) / tile_size;
+    m_tiles_y = (m_height + tile_size - 1) / tile_size;
+    const std::size_t tiles = static_cast<std::size_t>(m_tiles_x) * m_tiles_y;
+    m_tile_active.assign(tiles, 1); // the current state is unknown: start with every tile active
+    m_tile_queued.assign(tiles, 0);
+    m_tile_work.clear();
+    m_tile_work.reserve(tiles);
+}
+
+template <typename Real>
+std::size_t UnitsCoreT<Real>::active_tile_count() const
+{
+    return static_cast<std::size_t>(std::count(m_tile_active.begin(), m_tile_active.end(), 1));
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::mark_all_tiles_active()
+{
+    std::fill(m_tile_active.begin(), m_tile_active.end(), 1);
+}
+
+template <typename Real>
+void UnitsCoreT<Real>::step_active()
+{
+    const int W = m_width;
+    const int H = m_height;
+    const int TX = m_tiles_x;
+    const int TY = m_tiles_y;
+    const int ts = m_tile_size;
+    const compute_type threshold = m_active_threshold;
+    UNITS_STATS_START(stats_start);
+
+    // Work list: every active tile and its 8 neighbors, which receive its push contributions
+    m_tile_work.clear();
+    std::fill(m_tile_queued.begin(), m_tile_queued.end(), 0);
+    for (int ty = 0; ty < TY; ++ty) {
+        for (int tx = 0; tx < TX; ++tx) {
+            if (!m_tile_active[static_cast<std::size_t>(ty) * TX + tx]) continue;
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) {
+                    int nx = tx + dx;
+                    int ny = ty + dy;
+                    if (m_torus) {
+                        nx = (nx + TX) % TX;
+                        ny = (ny + TY) % TY;
+                    } else if (nx < 0 || nx >= TX || ny < 0 || ny >= TY) {
+                        continue;
+                    }
+                    const int t = ny * TX + nx;
+                    if (!m_tile_queued[t]) {
+                        m_tile_queued[t] = 1;
+                        m_tile_work.push_back(t);
+                    }
+                }
+            }
+        }
+    }
+    const int count = static_cast<int>(m_tile_work.size());
+
+    // Same two phases as step_fused(), per tile: integrate every queued tile, then (after a
+    // barrier) gather its delta_steps from the fresh deltas. Tiles outside the list
+    // are at rest, so their stale deltas are within the threshold of the dense result.
+#ifdef _OPENMP
+    #pragma omp parallel
+#endif
+    {
+        {
+            UNITS_TRACE_SCOPE("active_integrate");
+#ifdef _OPENMP
+            #pragma omp for schedule(dynamic, 4) nowait
+#endif
+            for (int i = 0; i < count; ++i) {
+                const int t = m_tile_work[i];
+                const int x0 = (t % TX) * ts;
+                const int x1 = std::min(x0 + ts, W);
+                const int y0 = (t / TX) * ts;
+                const int y1 = std::min(y0 + ts, H);
+                for (int y = y0; y < y1; ++y) {
+                    const std::size_t off = static_cast<std::size_t>(y) * W + x0;
+                    integrate_cells(&m_values[off], &m_deltas[off], &m_delta_steps[off], &m_targets[off],
+                                    static_cast<std::size_t>(x1 - x0), false, nullptr);
+                }
+            }
+        }
+#ifdef _OPENMP
+        #pragma omp barrier
+#endif
+
+        UNITS_TRACE_SCOPE("active_gather");
+#ifdef _OPENMP
+        #pragma omp for schedule(dynamic, 4) nowait
+#endif
+        for (int i = 0; i < count; ++i) {
+            const int t = m_tile_work[i];
+            const int x0 = (t % TX) * ts;
+            const int x1 = std::min(x0 + ts, W);
+            const int y0 = (t / TX) * ts;
+            const int y1 = std::min(y0 + ts, H);
+            bool active = false;
+            for (int y = y0; y < y1; ++y) {
+                gather_row(y, x0, x1, false);
+                const std::size_t row = static_cast<std::size_t>(y) * W;
+                for (std::size_t j = row + x0; j < row + x1 && !active; ++j) {
+                    const compute_type d = m_deltas[j];
+                    const compute_type ds = m_delta_steps[j];
+                    active = std::abs(d) > threshold || std::abs(ds) > threshold;
+                }
+            }
+            m_tile_active[t] = active ? 1 : 0;
+        }
+    }
+
+#if defined(USE_STATS)
+    std::size_t cells = 0;
+    for (int t : m_tile_work) {
+        cells += static_cast<std::size_t>(std::min(ts, W - (t % TX) * ts)) * std::min(ts, H - (t / TX) * ts);
+    }
+    // Like step_pooled(), over the stepped tiles' cells only
+    UNITS_STATS_STOP(UnitsPhase::Active, stats_start, 8 * cells * sizeof(Real));
+    ++m_stats.steps;
+#endif
+    count_steps(1);
+}
+
+template class UnitsCoreT<float>;
+template class UnitsCoreT<double>;
+template class UnitsCoreT<units_half>;
+template class UnitsCoreT<units_bfloat16>;
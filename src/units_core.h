@@ -3,62 +3,350 @@
 
 #include <vector>
 #include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "units_buffer.h"
+#include "units_half.h"
+#include "units_snapshot.h"
+#include "units_thread_pool.h"
 
 // Lightweight, cache-friendly core for Units simulation optimized for large grids.
-// Stores values in flat arrays and neighbor indices as integer lists (torus wiring by default).
+// Stores values in flat arrays and neighbor indices as integer lists (torus wiring by default),
+// or computes the fixed Moore stencil arithmetically (NeighborMode::Stencil) for regular grids.
 // Provides a simple two-phase step: update() then push(), and a convenience step() that runs both.
 
-// Allow compile-time choice of float vs double precision
-// Define UNITS_USE_FLOAT to prefer float (smaller memory footprint)
+// The engine is a class template over the scalar type (UnitsCoreT<float>, UnitsCoreT<double>),
+// so different precisions can coexist in one process. UnitsCore is the build's default
+// precision: define UNITS_USE_FLOAT to prefer float (smaller memory footprint).
+// UnitsCoreT<units_half> / UnitsCoreT<units_bfloat16> store every per-cell array in 16 bits
+// and compute in float (compute_type), halving the bandwidth again for memory-bound grids.
 #ifdef UNITS_USE_FLOAT
 using units_real = float;
 #else
 using units_real = double;
 #endif
 
-class UnitsCore {
+// How neighbor lists are represented:
+// - Explicit: materialized CSR arrays (m_neighbor_index_start / m_neighbors), ~9 ints per cell
+// - Stencil:  8-neighbour offsets computed on the fly; no neighbor arrays are allocated
+enum class UnitsNeighborMode { Explicit, Stencil };
+
+// How push() distributes contributions when running with OpenMP:
+// - Atomic:          shared accumulator with atomic adds (low memory, contention-bound)
+// - PerThreadAccum:  private N-sized accumulator per thread, merged afterwards
+// - HaloPartitioned: row band per thread, private accumulators only for the two halo rows
+// - Gather:          each cell sums its neighbors' contributions in a fixed order; results
+//                    are bit-identical to a serial push for any thread count
+// Without OpenMP only Atomic and Gather are available (and run serially).
+enum class UnitsPushStrategy { Atomic, PerThreadAccum, HaloPartitioned, Gather };
+
+struct UnitsPushTiming {
+    UnitsPushStrategy strategy;
+    double seconds_per_step;
+};
+
+// Norms of the deltas (targets - values) after an update
+struct UnitsDeltaNorms {
+    double linf; // max |delta|
+    double l2;   // sqrt(sum delta^2)
+};
+
+// Phases timed by the USE_STATS instrumentation:
+// - Update:   update() (integrate values, compute deltas)
+// - Scatter:  the scatter strategies' source loop (Atomic, PerThreadAccum, HaloPartitioned)
+// - Zero:     clearing the per-thread accumulators (PerThreadAccum)
+// - Merge:    applying accumulators to delta_steps (Atomic, PerThreadAccum, HaloPartitioned)
+// - Gather:   push() with PushStrategy::Gather
+// - Fused:    step_fused()
+// - Temporal: step_n()
+// - Active:   active-set step()
+// - Pooled:   thread-pool step() / step_many()
+enum class UnitsPhase { Update, Scatter, Zero, Merge, Gather, Fused, Temporal, Active, Pooled, Count };
+
+constexpr int kUnitsPhaseCount = static_cast<int>(UnitsPhase::Count);
+
+struct UnitsPhaseStats {
+    double seconds;     // cumulative wall time
+    std::uint64_t calls;
+    std::uint64_t bytes; // estimated memory traffic: every array the phase reads or writes,
+                         // streamed once per call (neighbor re-reads hit cache)
+};
+
+struct UnitsStats {
+    UnitsPhaseStats phases[kUnitsPhaseCount];
+    std::uint64_t steps; // grid steps completed (step_n(k) counts k)
+
+    const UnitsPhaseStats& operator[](UnitsPhase phase) const { return phases[static_cast<int>(phase)]; }
+};
+
+// Caller-owned state buffers for UnitsCoreT's adopting constructor and adopt(): each
+// non-null pointer must hold width * height elements, is used in place (never copied or
+// freed) and must outlive the engine or the next adopt(). Null members stay engine-owned.
+// Any alignment of Real works; 64-byte alignment (kUnitsBufferAlignment) keeps the SIMD
+// loads within cache lines, as with the engine's own buffers.
+template <typename Real>
+struct UnitsExternalState {
+    Real* values = nullptr;
+    Real* targets = nullptr;
+    Real* deltas = nullptr;
+    Real* delta_steps = nullptr;
+};
+
+template <typename Real>
+class UnitsCoreT {
 public:
-    UnitsCore(int width, int height, units_real max_value = 1.0, bool torus = true);
+    using real_type = Real;
+    using compute_type = typename units_compute_type<Real>::type;
+    using NeighborMode = UnitsNeighborMode;
+    using PushStrategy = UnitsPushStrategy;
+    using PushTiming = UnitsPushTiming;
+    using DeltaNorms = UnitsDeltaNorms;
+
+    UnitsCoreT(int width, int height, compute_type max_value = 1.0, bool torus = true,
+               NeighborMode neighbor_mode = NeighborMode::Explicit);
+    // Runs on the caller's buffers (see UnitsExternalState); their contents are the initial
+    // state, so write them with the same static partition as the stepping loops for NUMA locality
+    UnitsCoreT(int width, int height, const UnitsExternalState<Real>& state, compute_type max_value = 1.0,
+               bool torus = true, NeighborMode neighbor_mode = NeighborMode::Explicit);
 
     int width() const { return m_width; }
     int height() const { return m_height; }
+    bool torus() const { return m_torus; }
+    NeighborMode neighbor_mode() const { return m_neighbor_mode; }
     std::size_t size() const { return m_values.size(); }
 
-    void set_value(int x, int y, units_real v);
-    void set_value_index(std::size_t idx, units_real v);
-    units_real value_at(int x, int y) const;
-    units_real value_at_index(std::size_t idx) const;
+    void set_value(int x, int y, compute_type v);
+    void set_value_index(std::size_t idx, compute_type v);
+    compute_type value_at(int x, int y) const;
+    compute_type value_at_index(std::size_t idx) const;
+
+    // Bulk state access: copies all size() cells in parallel with the stepping loops' static
+    // partition; throws std::invalid_argument unless the span holds exactly size() elements.
+    // Setters reactivate every tile in active-set mode.
+    void set_values(UnitsSpan<const Real> values);
+    void set_targets(UnitsSpan<const Real> targets);
+    void set_deltas(UnitsSpan<const Real> deltas);
+    void get_values(UnitsSpan<Real> out) const;
+    void get_targets(UnitsSpan<Real> out) const;
+    void get_deltas(UnitsSpan<Real> out) const;
+
+    // Switches the non-null buffers of `state` to caller memory, taking their contents as the
+    // current state (the replaced buffers are freed). Throws std::invalid_argument for a
+    // pointer misaligned for Real.
+    void adopt(const UnitsExternalState<Real>& state);
 
     // Simulation steps
     void update(); // integrate values, compute deltas
     void push();   // distribute deltas to neighbors (writes into delta_steps)
-    void step() { update(); push(); }
+    void step()
+    {
+        if (active_set_enabled()) step_active();
+        else if (m_thread_pool) step_pooled(1);
+        else { update(); push(); }
+    }
+
+    // Runs count step()s; with a thread pool they all run inside a single pool job
+    void step_many(int count);
+
+    // Steps completed since construction (step_n(k) counts k, update() + push() counts one)
+    std::uint64_t step_count() const { return m_step_count; }
+
+    // Snapshots for concurrent readers (render, recording, analysis threads): with snapshots
+    // enabled, every `interval`-th step copies values into a triple buffer and publishes it
+    // with one atomic store, so readers get the latest complete frame without locks or tearing
+    // while the stepping thread carries on. interval <= 0 disables them and frees the buffers;
+    // no reader may hold a snapshot across this call. The entry points publish when they
+    // return (step_n(k) and pooled step_many() once per call).
+    void enable_snapshots(int interval = 1);
+    bool snapshots_enabled() const { return m_snapshot_interval > 0; }
+    // Publishes the current values now (e.g. after update(); push() or set_values())
+    void publish_snapshot();
+    // A reader for one thread: acquire() pins the latest snapshot, then data() / step() read
+    // it in place (no copy) until the next acquire(). Must not outlive the core.
+    UnitsSnapshotReader<Real> snapshot_reader() const { return UnitsSnapshotReader<Real>(m_snapshots); }
+
+    // Execution backend for step() / step_many(): with a pool, each call is one job on its
+    // persistent threads, integrate and gather phases separated by spin barriers, instead of
+    // one OpenMP region per phase. The push is always the deterministic gather (push_strategy()
+    // is ignored), so results are bit-identical to a serial step(). A pool can be shared by
+    // several cores; nullptr returns to OpenMP.
+    void set_thread_pool(std::shared_ptr<UnitsThreadPool> pool) { m_thread_pool = std::move(pool); }
+    const std::shared_ptr<UnitsThreadPool>& thread_pool() const { return m_thread_pool; }
+
+    // Single-pass alternative to step(): each row is integrated and then, one row behind,
+    // its delta_steps are gathered from the neighbors' fresh deltas in ascending source
+    // order. Bit-identical to a serial update(); push() and touches each array once.
+    void step_fused();
+
+    // Advances k steps with temporal blocking: the grid is cut into row bands, and each band
+    // plus a k-row halo is copied into a cache-sized tile and stepped k times there
+    // (overlapped trapezoid tiling) before being written back. Matches k sequential
+    // serial step() calls bit for bit.
+    void step_n(int k);
 
-    // Access raw buffers for visualization
-    const std::vector<units_real>& values() const { return m_values; }
+    // Runs step() until max |delta| <= epsilon or max_steps steps have run, and returns the
+    // number of steps taken. The delta norms are reduced inside the update() loop, so the
+    // check costs no extra pass over memory.
+    int step_until(compute_type epsilon, int max_steps);
+    // Norms of the deltas computed by the last step_until() step
+    const DeltaNorms& delta_norms() const { return m_delta_norms; }
+
+    // Active-set stepping for mostly quiescent grids: step() only integrates and gathers the
+    // tiles (tile_size x tile_size cells) holding some |delta| or |delta_step| above threshold,
+    // plus a one-tile halo, and re-evaluates those tiles afterwards; everything else is left
+    // at rest. Matches dense stepping to within the threshold. set_value() and the dense entry
+    // points (update(), step_fused(), step_n(), step_until()) reactivate tiles.
+    // A threshold <= 0 turns it off (the default).
+    void set_active_set(compute_type threshold, int tile_size = 32);
+    bool active_set_enabled() const { return m_active_threshold > 0; }
+    std::size_t active_tile_count() const;
+
+    // Push strategy, initially USE_PER_THREAD_ACCUM / USE_HALO_PUSH from the build, else Gather
+    // with USE_SIMD and Atomic otherwise. The strategy's scratch buffers are allocated here
+    // (and at construction) for the current OpenMP thread count, so that step() does not
+    // touch the heap; they only grow if the thread count is raised later.
+    PushStrategy push_strategy() const { return m_push_strategy; }
+    void set_push_strategy(PushStrategy strategy); // throws if not available in this build
+    static std::vector<PushStrategy> available_push_strategies();
+    static const char* push_strategy_name(PushStrategy strategy);
+
+    // Times `steps` steps of every available strategy on this grid and thread count, keeps
+    // the fastest and returns the measurements. The simulation state is restored afterwards.
+    std::vector<PushTiming> autotune(int steps = 5);
+
+    // SIMD path used by the kernels: "avx512", "avx2" or "scalar" when built with USE_SIMD,
+    // "disabled" otherwise
+    static const char* simd_isa();
+
+    // 64-bit hash of the simulation state (values, deltas, delta_steps). Independent of the
+    // thread count; equal hashes after the same steps mean bit-identical grids.
+    std::uint64_t state_hash() const;
+
+    // Pages of the state buffers (values, targets, deltas, delta_steps) on each NUMA node,
+    // index = node id; empty where placement cannot be queried. The buffers are first-touched
+    // with the stepping loops' static partition, so with pinned threads each thread's cells
+    // are local to it.
+    std::vector<std::size_t> numa_pages_per_node() const;
+
+    // Per-phase cumulative time, call counts and estimated bytes since construction or
+    // reset_stats(). Only recorded when built with USE_STATS (stats_enabled()); otherwise the
+    // timers compile away and every field stays zero.
+    static constexpr bool stats_enabled()
+    {
+#if defined(USE_STATS)
+        return true;
+#else
+        return false;
+#endif
+    }
+    const UnitsStats& stats() const { return m_stats; }
+    void reset_stats() { m_stats = UnitsStats(); }
+    static const char* phase_name(UnitsPhase phase);
+
+    // Zero-copy views of the state buffers, valid until the engine is destroyed or adopt().
+    // values() returned const units_vector<Real>& before external buffers existed; callers
+    // that need a vector copy the view or use get_values().
+    UnitsSpan<const Real> values() const { return { m_values.data(), m_values.size() }; }
+    UnitsSpan<const Real> targets() const { return { m_targets.data(), m_targets.size() }; }
+    UnitsSpan<const Real> deltas() const { return { m_deltas.data(), m_deltas.size() }; }
 
 private:
+    // Shared by the public constructors; a null state owns every buffer
+    UnitsCoreT(const UnitsExternalState<Real>* state, int width, int height, compute_type max_value, bool torus,
+               NeighborMode neighbor_mode);
     void build_neighbors(bool torus);
+    static PushStrategy default_push_strategy();
+    void reserve_push_scratch(); // sizes the current push strategy's scratch buffers
+
+    void update(DeltaNorms* norms); // update(), optionally reducing the new deltas' norms
+    void step_active();
+    void step_pooled(int count);
+    void mark_all_tiles_active(); // after steps that bypass the tile flags
+    void count_steps(std::uint64_t count); // advances step_count(), publishing a due snapshot
+    void record_phase(UnitsPhase phase, double seconds, std::uint64_t bytes); // USE_STATS builds
+
+    void push_atomic();
+    void push_per_thread_accum();   // OpenMP builds only
+    void push_halo_partitioned();   // OpenMP builds only
+    void push_gather();
+
+    // Calls add(neighbor_index, contribution) for every source cell in row y
+    template <typename Add>
+    void scatter_row(int y, Add&& add) const;
+
+    // update() body over n cells; delta_steps are left untouched when clear_delta_steps is false.
+    // A non-null norms[2] accumulates max |delta| and sum delta^2 of the new deltas.
+    void integrate_cells(Real* values, Real* deltas, Real* delta_steps, const Real* targets,
+                         std::size_t n, bool clear_delta_steps, compute_type* norms) const;
+    void integrate_row(int y, bool clear_delta_steps);
+    // Gathers the push contributions into columns [x_lo, x_hi) of row y (overwrite or
+    // accumulate). The pointer form takes the delta rows above/at/below y and the output row,
+    // so it also runs on tile-local copies.
+    void gather_row(int y, int x_lo, int x_hi, const Real* up, const Real* mid, const Real* down,
+                    Real* out, bool accumulate) const;
+    void gather_row(int y, int x_lo, int x_hi, bool accumulate);
+    void gather_row(int y, bool accumulate) { gather_row(y, 0, m_width, accumulate); }
+    compute_type gather_cell(int x, int y, const Real* const rows[3]) const;
 
     int m_width;
     int m_height;
-    units_real m_max_value;
+    compute_type m_max_value;
+    bool m_torus;
+    NeighborMode m_neighbor_mode;
+    PushStrategy m_push_strategy;
+    DeltaNorms m_delta_norms;
 
-    std::vector<units_real> m_values;
-    std::vector<units_real> m_targets;
-    std::vector<units_real> m_deltas;
-    std::vector<units_real> m_delta_steps;
+    // Engine-owned, or caller memory after adopt()
+    units_array<Real> m_values;
+    units_array<Real> m_targets;
+    units_array<Real> m_deltas;
+    units_array<Real> m_delta_steps;
 
     // flattened neighbor indices: for each cell, store contiguous block of neighbor indices
-    std::vector<int> m_neighbor_index_start; // start offset into m_neighbors per cell
-    std::vector<int> m_neighbors; // concatenated neighbor lists
-
-#if defined(USE_PER_THREAD_ACCUM)
-    // Per-thread accumulator buffer for push algorithm (allocated once, reused each step)
-    // Type matches the chosen precision (units_real). Allocation and use should be
-    // guarded by USE_PER_THREAD_ACCUM and OpenMP at the implementation sites.
-    std::vector<units_real> m_per_thread_accum;
-#endif
+    // (left empty in NeighborMode::Stencil)
+    units_vector<int> m_neighbor_index_start; // start offset into m_neighbors per cell
+    units_vector<int> m_neighbors; // concatenated neighbor lists
+
+    // Scratch for step_n(): per-band halo rows and per-thread tiles (grown on demand)
+    units_vector<Real> m_halo_scratch;
+    units_vector<Real> m_tile_scratch;
+
+    // Shared accumulator for PushStrategy::Atomic (N values, zeroed as it is applied)
+    units_vector<compute_type> m_push_accum;
+
+    // Per-thread accumulator buffer for PushStrategy::PerThreadAccum (num_threads * N)
+    units_vector<compute_type> m_per_thread_accum;
+
+    // PushStrategy::HaloPartitioned: per-thread accumulators for the row above and below the
+    // thread's band, laid out as [thread][top row | bottom row] (2 * width per thread)
+    units_vector<compute_type> m_halo_accum;
+
+    // Active-set stepping: per-tile activity flags, and the tiles stepped this step (active
+    // ones plus their neighbors; m_tile_queued dedupes)
+    compute_type m_active_threshold;
+    int m_tile_size;
+    int m_tiles_x;
+    int m_tiles_y;
+    std::vector<unsigned char> m_tile_active;
+    std::vector<unsigned char> m_tile_queued;
+    std::vector<int> m_tile_work;
+
+    std::shared_ptr<UnitsThreadPool> m_thread_pool;
+
+    std::uint64_t m_step_count;
+    int m_snapshot_interval; // 0 = no snapshots
+    UnitsSnapshotBuffer<Real> m_snapshots;
+
+    UnitsStats m_stats;
 };
 
+// Explicitly instantiated in units_core.cpp
+extern template class UnitsCoreT<float>;
+extern template class UnitsCoreT<double>;
+extern template class UnitsCoreT<units_half>;
+extern template class UnitsCoreT<units_bfloat16>;
+
+using UnitsCore = UnitsCoreT<units_real>;
+
 #endif // UNITS_CORE_H
\ No newline at end of file
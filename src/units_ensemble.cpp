@@ -0,0 +1,216 @@
+#include "units_ensemble.h"
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined(USE_SIMD)
+#include "units_simd.h"
+#endif
+
+#include "units_stencil.h"
+#include "units_trace.h"
+
+namespace {
+
+// Instances per gather block in the scalar build: the partial sums of one block stay in
+// L1, and the fixed-size inner loops vectorize across instances
+constexpr int kInstanceBlock = 64;
+
+} // namespace
+
+template <typename Real>
+UnitsEnsembleT<Real>::UnitsEnsembleT(int width, int height, int instances, compute_type max_value, bool torus)
+    : m_width(width),
+      m_height(height),
+      m_instances(instances),
+      m_max_value(max_value),
+      m_torus(torus)
+{
+    if (width <= 0 || height <= 0) throw std::invalid_argument("width/height must be > 0");
+    if (instances <= 0) throw std::invalid_argument("instances must be > 0");
+
+    const std::size_t total = cells() * static_cast<std::size_t>(instances);
+    const Real zero = static_cast<compute_type>(0.0);
+    units_first_touch(m_values, total, zero);
+    units_first_touch(m_targets, total, zero);
+    units_first_touch(m_deltas, total, zero);
+    units_first_touch(m_delta_steps, total, zero);
+
+    build_sources();
+}
+
+template <typename Real>
+void UnitsEnsembleT<Real>::build_sources()
+{
+    const int W = m_width;
+    const int H = m_height;
+    const std::size_t N = cells();
+
+    // The Moore stencil is symmetric, so the sources of a cell are its neighbors; sorting them
+    // by index reproduces the order in which UnitsCoreT's serial scatter adds them
+    m_source_start.assign(N + 1, 0);
+    m_sources.clear();
+    m_source_degree.clear();
+    m_sources.reserve(N * 8);
+    m_source_degree.reserve(N * 8);
+
+    for (int y = 0; y < H; ++y) {
+        for (int x = 0; x < W; ++x) {
+            const std::size_t idx = static_cast<std::size_t>(y) * W + x;
+            int nbs[8];
+            int count = 0;
+            units_stencil::for_each_moore_neighbor(x, y, W, H, m_torus, [&](int nx, int ny, int) {
+                nbs[count++] = ny * W + nx;
+            });
+            // At most 8 entries: insertion sort
+            for (int i = 1; i < count; ++i) {
+                const int nb = nbs[i];
+                int j = i;
+                for (; j > 0 && nbs[j - 1] > nb; --j) nbs[j] = nbs[j - 1];
+                nbs[j] = nb;
+            }
+            for (int i = 0; i < count; ++i) {
+                m_sources.push_back(nbs[i]);
+                m_source_degree.push_back(static_cast<compute_type>(
+                    units_stencil::moore_degree(nbs[i] % W, nbs[i] / W, W, H, m_torus)));
+            }
+            m_source_start[idx + 1] = static_cast<int>(m_sources.size());
+        }
+    }
+}
+
+template <typename Real>
+std::size_t UnitsEnsembleT<Real>::slot(int instance, std::size_t idx) const
+{
+    return idx * static_cast<std::size_t>(m_instances) + static_cast<std::size_t>(instance);
+}
+
+template <typename Real>
+UnitsStridedView<Real> UnitsEnsembleT<Real>::view(const units_vector<Real>& buffer, int instance) const
+{
+    if (instance < 0 || instance >= m_instances) throw std::out_of_range("ensemble instance out of range");
+    return UnitsStridedView<Real>(buffer.data() + instance, cells(), static_cast<std::size_t>(m_instances));
+}
+
+template <typename Real>
+void UnitsEnsembleT<Real>::set_value(int instance, int x, int y, compute_type v)
+{
+    if (x < 0 || x >= m_width || y < 0 || y >= m_height) return;
+    set_value_index(instance, static_cast<std::size_t>(y) * m_width + x, v);
+}
+
+template <typename Real>
+void UnitsEnsembleT<Real>::set_value_index(int instance, std::size_t idx, compute_type v)
+{
+    if (instance < 0 || instance >= m_instances || idx >= cells()) return;
+    m_values[slot(instance, idx)] = v;
+}
+
+template <typename Real>
+typename UnitsEnsembleT<Real>::compute_type UnitsEnsembleT<Real>::value_at(int instance, int x, int y) const
+{
+    if (x < 0 || x >= m_width || y < 0 || y >= m_height) return static_cast<compute_type>(0.0);
+    return value_at_index(instance, static_cast<std::size_t>(y) * m_width + x);
+}
+
+template <typename Real>
+typename UnitsEnsembleT<Real>::compute_type UnitsEnsembleT<Real>::value_at_index(int instance, std::size_t idx) const
+{
+    if (instance < 0 || instance >= m_instances || idx >= cells()) return static_cast<compute_type>(0.0);
+    return m_values[slot(instance, idx)];
+}
+
+template <typename Real>
+void UnitsEnsembleT<Real>::set_target_index(int instance, std::size_t idx, compute_type v)
+{
+    if (instance < 0 || instance >= m_instances || idx >= cells()) return;
+    m_targets[slot(instance, idx)] = v;
+}
+
+template <typename Real>
+void UnitsEnsembleT<Real>::step()
+{
+    const std::size_t K = static_cast<std::size_t>(m_instances);
+    const std::size_t total = m_values.size();
+    const int N = static_cast<int>(cells());
+
+    Real* const values = m_values.data();
+    Real* const deltas = m_deltas.data();
+    Real* const delta_steps = m_delta_steps.data();
+    const Real* const targets = m_targets.data();
+
+#ifdef _OPENMP
+    #pragma omp parallel
+#endif
+    {
+        int tid = 0;
+        int num_threads = 1;
+#ifdef _OPENMP
+        tid = omp_get_thread_num();
+        num_threads = omp_get_num_threads();
+#endif
+        // Phase 1: integrate. The interleaved arrays are one flat buffer of cells * K slots,
+        // so this is UnitsCoreT::update() over a longer array; static per-thread ranges
+        const std::size_t begin = total * tid / num_threads;
+        const std::size_t end = total * (tid + 1) / num_threads;
+        {
+            UNITS_TRACE_SCOPE("ensemble_integrate");
+#if defined(USE_SIMD)
+            if (end > begin) {
+                units_simd::integrate(values + begin, deltas + begin, delta_steps + begin, targets + begin,
+                                      end - begin, m_max_value, true, nullptr);
+            }
+#else
+            for (std::size_t i = begin; i < end; ++i) {
+                compute_type v = values[i] + delta_steps[i] + deltas[i];
+                if (v > m_max_value) v = m_max_value;
+                else if (v < -m_max_value) v = -m_max_value;
+                values[i] = v;
+                deltas[i] = targets[i] - v;
+                delta_steps[i] = 0.0;
+            }
+#endif
+        }
+
+#ifdef _OPENMP
+        #pragma omp barrier
+#endif
+
+        // Phase 2: gather. Each cell sums its sources' contributions in ascending source index
+        // (as the serial scatter does) for all K instances: the inner loops run over
+        // contiguous instance slots.
+        UNITS_TRACE_SCOPE("ensemble_gather");
+#ifdef _OPENMP
+        #pragma omp for schedule(static) nowait
+#endif
+        for (int c = 0; c < N; ++c) {
+            const int s_begin = m_source_start[c];
+            const int s_end = m_source_start[c + 1];
+            Real* const out = delta_steps + static_cast<std::size_t>(c) * K;
+#if defined(USE_SIMD)
+            units_simd::gather_sources(out, deltas, &m_sources[s_begin], &m_source_degree[s_begin],
+                                       s_end - s_begin, K, K);
+#else
+            for (std::size_t k0 = 0; k0 < K; k0 += kInstanceBlock) {
+                const int lanes = static_cast<int>(std::min<std::size_t>(kInstanceBlock, K - k0));
+                compute_type sum[kInstanceBlock];
+                for (int k = 0; k < lanes; ++k) sum[k] = 0.0;
+                for (int s = s_begin; s < s_end; ++s) {
+                    const Real* const src = deltas + static_cast<std::size_t>(m_sources[s]) * K + k0;
+                    const compute_type degree = m_source_degree[s];
+                    for (int k = 0; k < lanes; ++k) sum[k] += -static_cast<compute_type>(src[k]) / degree;
+                }
+                for (int k = 0; k < lanes; ++k) out[k0 + k] = sum[k];
+            }
+#endif
+        }
+    }
+}
+
+template class UnitsEnsembleT<float>;
+template class UnitsEnsembleT<double>;
+template class UnitsEnsembleT<units_half>;
+template class UnitsEnsembleT<units_bfloat16>;
@@ -0,0 +1,94 @@
+#ifndef UNITS_ENSEMBLE_H
+#define UNITS_ENSEMBLE_H
+
+#include <vector>
+#include <cstddef>
+
+#include "units_core.h"
+
+// Read-only strided view of one instance's array inside an interleaved ensemble buffer
+template <typename T>
+class UnitsStridedView {
+public:
+    UnitsStridedView(const T* data, std::size_t size, std::size_t stride)
+        : m_data(data), m_size(size), m_stride(stride) {}
+
+    std::size_t size() const { return m_size; }
+    std::size_t stride() const { return m_stride; }
+    const T* data() const { return m_data; }
+    const T& operator[](std::size_t i) const { return m_data[i * m_stride]; }
+
+private:
+    const T* m_data;
+    std::size_t m_size;
+    std::size_t m_stride;
+};
+
+// K independent grids of the same size and wiring, stepped together. Parameter sweeps of
+// many small grids would otherwise pay K neighbor topologies and K OpenMP fork/joins per
+// phase; here the per-cell arrays are interleaved cell-major, instance-minor
+// (index = cell * K + instance), the topology is built once, and one step() advances every
+// instance: threads split the cells, and the instance dimension is the contiguous inner loop
+// that maps onto SIMD lanes. Each instance evolves exactly like a UnitsCoreT<Real> with the
+// same initial values and targets (bit for bit).
+template <typename Real>
+class UnitsEnsembleT {
+public:
+    using real_type = Real;
+    using compute_type = typename units_compute_type<Real>::type;
+
+    UnitsEnsembleT(int width, int height, int instances, compute_type max_value = 1.0, bool torus = true);
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    int instances() const { return m_instances; }
+    bool torus() const { return m_torus; }
+    std::size_t cells() const { return static_cast<std::size_t>(m_width) * m_height; } // per instance
+
+    void set_value(int instance, int x, int y, compute_type v);
+    void set_value_index(int instance, std::size_t idx, compute_type v);
+    compute_type value_at(int instance, int x, int y) const;
+    compute_type value_at_index(int instance, std::size_t idx) const;
+    void set_target_index(int instance, std::size_t idx, compute_type v);
+
+    // One update(); push() of every instance in a single parallel region
+    void step();
+
+    // Per-instance strided views (stride = instances())
+    UnitsStridedView<Real> values(int instance) const { return view(m_values, instance); }
+    UnitsStridedView<Real> targets(int instance) const { return view(m_targets, instance); }
+    // Interleaved buffer, index = cell * instances() + instance
+    const units_vector<Real>& values() const { return m_values; }
+
+private:
+    void build_sources();
+    std::size_t slot(int instance, std::size_t idx) const;
+    UnitsStridedView<Real> view(const units_vector<Real>& buffer, int instance) const;
+
+    int m_width;
+    int m_height;
+    int m_instances;
+    compute_type m_max_value;
+    bool m_torus;
+
+    units_vector<Real> m_values;
+    units_vector<Real> m_targets;
+    units_vector<Real> m_deltas;
+    units_vector<Real> m_delta_steps;
+
+    // Shared topology: for each cell, the source cells pushing into it in ascending index
+    // order (the serial scatter's summation order) and their degrees
+    std::vector<int> m_source_start; // N + 1 offsets into m_sources
+    std::vector<int> m_sources;
+    std::vector<compute_type> m_source_degree;
+};
+
+// Explicitly instantiated in units_ensemble.cpp
+extern template class UnitsEnsembleT<float>;
+extern template class UnitsEnsembleT<double>;
+extern template class UnitsEnsembleT<units_half>;
+extern template class UnitsEnsembleT<units_bfloat16>;
+
+using UnitsEnsemble = UnitsEnsembleT<units_real>;
+
+#endif // UNITS_ENSEMBLE_H
@@ -0,0 +1,129 @@
+#ifndef UNITS_HALF_H
+#define UNITS_HALF_H
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+// 16-bit storage formats for UnitsCoreT<units_half> / UnitsCoreT<units_bfloat16>.
+// They only hold values: arithmetic converts to float implicitly, and stores round back to
+// nearest even. Half the bytes of float per cell, for memory-bound grids that only need
+// a few significant digits (e.g. visualization runs).
+// - units_half:     IEEE 754 binary16, ~3.3 significant digits, range +-65504
+// - units_bfloat16: upper 16 bits of a float, ~2.4 significant digits, float range
+// The scalar conversions use F16C when the compiler targets it (e.g. -march=native); the
+// USE_SIMD kernels convert whole vectors with F16C / AVX-512 regardless.
+
+inline float units_half_to_float(std::uint16_t h)
+{
+#if defined(__F16C__)
+    return _cvtsh_ss(h);
+#else
+    const std::uint32_t sign = static_cast<std::uint32_t>(h & 0x8000u) << 16;
+    std::uint32_t exponent = (h >> 10) & 0x1Fu;
+    std::uint32_t mantissa = h & 0x3FFu;
+    std::uint32_t bits;
+    if (exponent == 0x1Fu) {
+        bits = sign | 0x7F800000u | (mantissa << 13); // inf / NaN (quieted, like F16C)
+        if (mantissa) bits |= 0x400000u;
+    } else if (exponent != 0) {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    } else if (mantissa == 0) {
+        bits = sign;
+    } else {
+        // Subnormal half: normalize into a float exponent
+        exponent = 113;
+        while (!(mantissa & 0x400u)) {
+            mantissa <<= 1;
+            --exponent;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3FFu) << 13);
+    }
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+#endif
+}
+
+inline std::uint16_t units_float_to_half(float f)
+{
+#if defined(__F16C__)
+    return static_cast<std::uint16_t>(_cvtss_sh(f, _MM_FROUND_TO_NEAREST_INT));
+#else
+    std::uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+    const std::uint32_t sign = (x >> 16) & 0x8000u;
+    x &= 0x7FFFFFFFu;
+
+    std::uint32_t h;
+    if (x > 0x7F800000u) {
+        h = 0x7E00u | ((x >> 13) & 0x3FFu); // quiet NaN, keeping the top payload bits
+    } else if (x >= 0x477FF000u) {
+        h = 0x7C00u; // inf, or rounds past 65504
+    } else if (x >= 0x38800000u) {
+        // Normal half: rebias the exponent, round the mantissa to nearest even (a carry
+        // correctly bumps the exponent)
+        h = x - 0x38000000u;
+        h = (h + 0xFFFu + ((h >> 13) & 1u)) >> 13;
+    } else if (x >= 0x33000000u) {
+        // Subnormal half: shift the full mantissa into units of 2^-24
+        const std::uint32_t shift = 126 - (x >> 23);
+        const std::uint32_t mantissa = (x & 0x7FFFFFu) | 0x800000u;
+        const std::uint32_t rest = mantissa & ((1u << shift) - 1);
+        const std::uint32_t halfway = 1u << (shift - 1);
+        h = mantissa >> shift;
+        if (rest > halfway || (rest == halfway && (h & 1u))) ++h;
+    } else {
+        h = 0; // below half of the smallest subnormal
+    }
+    return static_cast<std::uint16_t>(sign | h);
+#endif
+}
+
+inline float units_bfloat16_to_float(std::uint16_t b)
+{
+    const std::uint32_t bits = static_cast<std::uint32_t>(b) << 16;
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+inline std::uint16_t units_float_to_bfloat16(float f)
+{
+    std::uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+    if ((x & 0x7FFFFFFFu) > 0x7F800000u) return static_cast<std::uint16_t>((x >> 16) | 0x40u); // quiet NaN
+    x += 0x7FFFu + ((x >> 16) & 1u); // round to nearest even
+    return static_cast<std::uint16_t>(x >> 16);
+}
+
+struct units_half {
+    std::uint16_t bits;
+
+    units_half() = default;
+    units_half(float f) : bits(units_float_to_half(f)) {}
+    operator float() const { return units_half_to_float(bits); }
+    units_half& operator+=(float x) { return *this = float(*this) + x; }
+};
+
+struct units_bfloat16 {
+    std::uint16_t bits;
+
+    units_bfloat16() = default;
+    units_bfloat16(float f) : bits(units_float_to_bfloat16(f)) {}
+    operator float() const { return units_bfloat16_to_float(bits); }
+    units_bfloat16& operator+=(float x) { return *this = float(*this) + x; }
+};
+
+// Arithmetic type for a storage type: 16-bit formats compute in float
+template <typename Real>
+struct units_compute_type { using type = Real; };
+template <>
+struct units_compute_type<units_half> { using type = float; };
+template <>
+struct units_compute_type<units_bfloat16> { using type = float; };
+
+#endif // UNITS_HALF_H
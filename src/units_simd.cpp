@@ -0,0 +1,212 @@
+#include "units_simd.h"
+#include "units_simd_kernels.h"
+#include "units_half.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace units_simd {
+
+#if defined(UNITS_SIMD_X86)
+namespace avx2 {
+void integrate(float*, float*, float*, const float*, std::size_t, float, bool, float*);
+void integrate(double*, double*, double*, const double*, std::size_t, double, bool, double*);
+void gather_interior(float*, const float*, const float*, const float*, std::size_t, bool);
+void gather_interior(double*, const double*, const double*, const double*, std::size_t, bool);
+void integrate(units_half*, units_half*, units_half*, const units_half*, std::size_t, float, bool, float*);
+void integrate(units_bfloat16*, units_bfloat16*, units_bfloat16*, const units_bfloat16*, std::size_t, float, bool,
+               float*);
+void gather_interior(units_half*, const units_half*, const units_half*, const units_half*, std::size_t, bool);
+void gather_interior(units_bfloat16*, const units_bfloat16*, const units_bfloat16*, const units_bfloat16*,
+                     std::size_t, bool);
+void gather_sources(float*, const float*, const int*, const float*, int, std::size_t, std::size_t);
+void gather_sources(double*, const double*, const int*, const double*, int, std::size_t, std::size_t);
+void gather_sources(units_half*, const units_half*, const int*, const float*, int, std::size_t, std::size_t);
+void gather_sources(units_bfloat16*, const units_bfloat16*, const int*, const float*, int, std::size_t,
+                    std::size_t);
+} // namespace avx2
+namespace avx512 {
+void integrate(float*, float*, float*, const float*, std::size_t, float, bool, float*);
+void integrate(double*, double*, double*, const double*, std::size_t, double, bool, double*);
+void gather_interior(float*, const float*, const float*, const float*, std::size_t, bool);
+void gather_interior(double*, const double*, const double*, const double*, std::size_t, bool);
+void integrate(units_half*, units_half*, units_half*, const units_half*, std::size_t, float, bool, float*);
+void integrate(units_bfloat16*, units_bfloat16*, units_bfloat16*, const units_bfloat16*, std::size_t, float, bool,
+               float*);
+void gather_interior(units_half*, const units_half*, const units_half*, const units_half*, std::size_t, bool);
+void gather_interior(units_bfloat16*, const units_bfloat16*, const units_bfloat16*, const units_bfloat16*,
+                     std::size_t, bool);
+void gather_sources(float*, const float*, const int*, const float*, int, std::size_t, std::size_t);
+void gather_sources(double*, const double*, const int*, const double*, int, std::size_t, std::size_t);
+void gather_sources(units_half*, const units_half*, const int*, const float*, int, std::size_t, std::size_t);
+void gather_sources(units_bfloat16*, const units_bfloat16*, const int*, const float*, int, std::size_t,
+                    std::size_t);
+} // namespace avx512
+#endif
+
+namespace {
+
+// One-lane "vector" so the scalar fallback shares the kernel bodies. 16-bit storage types
+// convert implicitly to and from their float compute type.
+template <typename Real, typename Compute = typename units_compute_type<Real>::type>
+struct Scalar {
+    using T = Real;
+    using C = Compute;
+    using V = Compute;
+    static constexpr std::size_t lanes = 1;
+    static V load(const T* p) { return *p; }
+    static void store(T* p, V v) { *p = v; }
+    static void spill(C* p, V v) { *p = v; }
+    static C to_c(T x) { return x; }
+    static T from_c(C x) { return x; }
+    static V set1(C x) { return x; }
+    static V zero() { return 0.0; }
+    static V add(V a, V b) { return a + b; }
+    static V sub(V a, V b) { return a - b; }
+    static V mul(V a, V b) { return a * b; }
+    static V div(V a, V b) { return a / b; }
+    static V min(V a, V b) { return a < b ? a : b; }
+    static V max(V a, V b) { return a > b ? a : b; }
+    static V neg(V a) { return -a; }
+};
+
+Isa detect_isa()
+{
+    Isa best = Isa::Scalar;
+#if defined(UNITS_SIMD_X86)
+    __builtin_cpu_init();
+    // Both x86 paths also use F16C for the 16-bit storage kernels
+    if (__builtin_cpu_supports("f16c")) {
+        if (__builtin_cpu_supports("avx512f")) best = Isa::AVX512;
+        else if (__builtin_cpu_supports("avx2")) best = Isa::AVX2;
+    }
+#endif
+
+    // Optional override to force a narrower path (never a wider one than the CPU supports)
+    if (const char* env = std::getenv("UNITS_SIMD")) {
+        Isa requested = best;
+        if (std::strcmp(env, "scalar") == 0) requested = Isa::Scalar;
+        else if (std::strcmp(env, "avx2") == 0) requested = Isa::AVX2;
+        else if (std::strcmp(env, "avx512") == 0) requested = Isa::AVX512;
+        if (static_cast<int>(requested) < static_cast<int>(best)) best = requested;
+    }
+    return best;
+}
+
+} // namespace
+
+Isa active_isa()
+{
+    static const Isa isa = detect_isa();
+    return isa;
+}
+
+const char* isa_name(Isa isa)
+{
+    switch (isa) {
+    case Isa::AVX512: return "avx512";
+    case Isa::AVX2: return "avx2";
+    default: return "scalar";
+    }
+}
+
+#if defined(UNITS_SIMD_X86)
+#define UNITS_SIMD_DISPATCH(fn, ...)                                   \
+    switch (active_isa()) {                                            \
+    case Isa::AVX512: avx512::fn(__VA_ARGS__); return;                 \
+    case Isa::AVX2: avx2::fn(__VA_ARGS__); return;                     \
+    default: break;                                                    \
+    }
+#else
+#define UNITS_SIMD_DISPATCH(fn, ...)
+#endif
+
+void integrate(float* values, float* deltas, float* delta_steps, const float* targets,
+               std::size_t n, float max_value, bool clear_delta_steps, float* norms)
+{
+    UNITS_SIMD_DISPATCH(integrate, values, deltas, delta_steps, targets, n, max_value, clear_delta_steps, norms)
+    kernels::integrate<Scalar<float>>(values, deltas, delta_steps, targets, n, max_value, clear_delta_steps,
+                                      norms);
+}
+
+void integrate(double* values, double* deltas, double* delta_steps, const double* targets,
+               std::size_t n, double max_value, bool clear_delta_steps, double* norms)
+{
+    UNITS_SIMD_DISPATCH(integrate, values, deltas, delta_steps, targets, n, max_value, clear_delta_steps, norms)
+    kernels::integrate<Scalar<double>>(values, deltas, delta_steps, targets, n, max_value, clear_delta_steps,
+                                       norms);
+}
+
+void gather_interior(float* out, const float* up, const float* mid, const float* down,
+                     std::size_t n, bool accumulate)
+{
+    UNITS_SIMD_DISPATCH(gather_interior, out, up, mid, down, n, accumulate)
+    kernels::gather_interior<Scalar<float>>(out, up, mid, down, n, accumulate);
+}
+
+void gather_interior(double* out, const double* up, const double* mid, const double* down,
+                     std::size_t n, bool accumulate)
+{
+    UNITS_SIMD_DISPATCH(gather_interior, out, up, mid, down, n, accumulate)
+    kernels::gather_interior<Scalar<double>>(out, up, mid, down, n, accumulate);
+}
+
+void integrate(units_half* values, units_half* deltas, units_half* delta_steps, const units_half* targets,
+               std::size_t n, float max_value, bool clear_delta_steps, float* norms)
+{
+    UNITS_SIMD_DISPATCH(integrate, values, deltas, delta_steps, targets, n, max_value, clear_delta_steps, norms)
+    kernels::integrate<Scalar<units_half>>(values, deltas, delta_steps, targets, n, max_value, clear_delta_steps,
+                                           norms);
+}
+
+void integrate(units_bfloat16* values, units_bfloat16* deltas, units_bfloat16* delta_steps,
+               const units_bfloat16* targets, std::size_t n, float max_value, bool clear_delta_steps,
+               float* norms)
+{
+    UNITS_SIMD_DISPATCH(integrate, values, deltas, delta_steps, targets, n, max_value, clear_delta_steps, norms)
+    kernels::integrate<Scalar<units_bfloat16>>(values, deltas, delta_steps, targets, n, max_value, clear_delta_steps,
+                                               norms);
+}
+
+void gather_interior(units_half* out, const units_half* up, const units_half* mid, const units_half* down,
+                     std::size_t n, bool accumulate)
+{
+    UNITS_SIMD_DISPATCH(gather_interior, out, up, mid, down, n, accumulate)
+    kernels::gather_interior<Scalar<units_half>>(out, up, mid, down, n, accumulate);
+}
+
+void gather_interior(units_bfloat16* out, const units_bfloat16* up, const units_bfloat16* mid,
+                     const units_bfloat16* down, std::size_t n, bool accumulate)
+{
+    UNITS_SIMD_DISPATCH(gather_interior, out, up, mid, down, n, accumulate)
+    kernels::gather_interior<Scalar<units_bfloat16>>(out, up, mid, down, n, accumulate);
+}
+
+void gather_sources(float* out, const float* deltas, const int* sources, const float* degrees, int count,
+                    std::size_t stride, std::size_t n)
+{
+    UNITS_SIMD_DISPATCH(gather_sources, out, deltas, sources, degrees, count, stride, n)
+    kernels::gather_sources<Scalar<float>>(out, deltas, sources, degrees, count, stride, n);
+}
+
+void gather_sources(double* out, const double* deltas, const int* sources, const double* degrees, int count,
+                    std::size_t stride, std::size_t n)
+{
+    UNITS_SIMD_DISPATCH(gather_sources, out, deltas, sources, degrees, count, stride, n)
+    kernels::gather_sources<Scalar<double>>(out, deltas, sources, degrees, count, stride, n);
+}
+
+void gather_sources(units_half* out, const units_half* deltas, const int* sources, const float* degrees,
+                    int count, std::size_t stride, std::size_t n)
+{
+    UNITS_SIMD_DISPATCH(gather_sources, out, deltas, sources, degrees, count, stride, n)
+    kernels::gather_sources<Scalar<units_half>>(out, deltas, sources, degrees, count, stride, n);
+}
+
+void gather_sources(units_bfloat16* out, const units_bfloat16* deltas, const int* sources, const float* degrees,
+                    int count, std::size_t stride, std::size_t n)
+{
+    UNITS_SIMD_DISPATCH(gather_sources, out, deltas, sources, degrees, count, stride, n)
+    kernels::gather_sources<Scalar<units_bfloat16>>(out, deltas, sources, degrees, count, stride, n);
+}
+
+} // namespace units_simd
@@ -0,0 +1,64 @@
+#ifndef UNITS_SIMD_H
+#define UNITS_SIMD_H
+
+#include <cstddef>
+
+// Explicit SIMD kernels for the hot loops of UnitsCore (built when USE_SIMD is ON).
+// One binary carries scalar, AVX2 and AVX-512 variants; the widest one supported by the
+// running CPU is picked once via CPUID. Set UNITS_SIMD=scalar|avx2|avx512 in the
+// environment to force a narrower path for comparisons.
+//
+// All kernels reproduce the scalar loops in units_core.cpp bit for bit (same operation
+// order, no FMA contraction), so the ISA choice never changes simulation results.
+// The 16-bit storage overloads load through F16C / bit shifts, compute in float and round
+// back to nearest even on store, like the implicit conversions in units_half.h.
+
+struct units_half;
+struct units_bfloat16;
+
+namespace units_simd {
+
+enum class Isa { Scalar, AVX2, AVX512 };
+
+Isa active_isa();
+const char* isa_name(Isa isa);
+
+// update() body: v = clamp(values + delta_steps + deltas), deltas = targets - v,
+// and delta_steps = 0 when clear_delta_steps is set. A non-null norms[2] is updated with the
+// new deltas: norms[0] = max(norms[0], |delta|), norms[1] += delta^2.
+void integrate(float* values, float* deltas, float* delta_steps, const float* targets,
+               std::size_t n, float max_value, bool clear_delta_steps, float* norms);
+void integrate(double* values, double* deltas, double* delta_steps, const double* targets,
+               std::size_t n, double max_value, bool clear_delta_steps, double* norms);
+void integrate(units_half* values, units_half* deltas, units_half* delta_steps, const units_half* targets,
+               std::size_t n, float max_value, bool clear_delta_steps, float* norms);
+void integrate(units_bfloat16* values, units_bfloat16* deltas, units_bfloat16* delta_steps,
+               const units_bfloat16* targets, std::size_t n, float max_value, bool clear_delta_steps,
+               float* norms);
+
+// Degree-8 stencil gather for n cells: out[x] (+)= sum of -delta/8 over the 8 neighbors,
+// summed in ascending index order. up/mid/down point at the first cell's column in the
+// rows above, at and below it; column -1 and n must be readable.
+void gather_interior(float* out, const float* up, const float* mid, const float* down,
+                     std::size_t n, bool accumulate);
+void gather_interior(double* out, const double* up, const double* mid, const double* down,
+                     std::size_t n, bool accumulate);
+void gather_interior(units_half* out, const units_half* up, const units_half* mid, const units_half* down,
+                     std::size_t n, bool accumulate);
+void gather_interior(units_bfloat16* out, const units_bfloat16* up, const units_bfloat16* mid,
+                     const units_bfloat16* down, std::size_t n, bool accumulate);
+
+// Interleaved gather for UnitsEnsembleT: for k < n, out[k] = sum over s < count of
+// -deltas[sources[s] * stride + k] / degrees[s], summed in the given source order.
+void gather_sources(float* out, const float* deltas, const int* sources, const float* degrees, int count,
+                    std::size_t stride, std::size_t n);
+void gather_sources(double* out, const double* deltas, const int* sources, const double* degrees, int count,
+                    std::size_t stride, std::size_t n);
+void gather_sources(units_half* out, const units_half* deltas, const int* sources, const float* degrees,
+                    int count, std::size_t stride, std::size_t n);
+void gather_sources(units_bfloat16* out, const units_bfloat16* deltas, const int* sources, const float* degrees,
+                    int count, std::size_t stride, std::size_t n);
+
+} // namespace units_simd
+
+#endif // UNITS_SIMD_H
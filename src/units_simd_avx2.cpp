@@ -0,0 +1,183 @@
+// AVX2 instantiation of the SIMD kernels. Compiled with -mavx2 -mf16c (see CMakeLists.txt)
+// and only called after CPUID confirmed AVX2 and F16C support.
+#include "units_simd.h"
+#include "units_simd_kernels.h"
+#include <immintrin.h>
+#include <stdint.h>
+
+namespace units_simd {
+namespace avx2 {
+
+namespace {
+
+struct F32 {
+    using T = float;
+    using C = float;
+    using V = __m256;
+    static constexpr std::size_t lanes = 8;
+    static V load(const T* p) { return _mm256_loadu_ps(p); }
+    static void store(T* p, V v) { _mm256_storeu_ps(p, v); }
+    static void spill(C* p, V v) { _mm256_storeu_ps(p, v); }
+    static C to_c(T x) { return x; }
+    static T from_c(C x) { return x; }
+    static V set1(T x) { return _mm256_set1_ps(x); }
+    static V zero() { return _mm256_setzero_ps(); }
+    static V add(V a, V b) { return _mm256_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+    static V div(V a, V b) { return _mm256_div_ps(a, b); }
+    static V min(V a, V b) { return _mm256_min_ps(a, b); }
+    static V max(V a, V b) { return _mm256_max_ps(a, b); }
+    static V neg(V a) { return _mm256_xor_ps(a, _mm256_set1_ps(-0.0f)); }
+};
+
+struct F64 {
+    using T = double;
+    using C = double;
+    using V = __m256d;
+    static constexpr std::size_t lanes = 4;
+    static V load(const T* p) { return _mm256_loadu_pd(p); }
+    static void store(T* p, V v) { _mm256_storeu_pd(p, v); }
+    static void spill(C* p, V v) { _mm256_storeu_pd(p, v); }
+    static C to_c(T x) { return x; }
+    static T from_c(C x) { return x; }
+    static V set1(T x) { return _mm256_set1_pd(x); }
+    static V zero() { return _mm256_setzero_pd(); }
+    static V add(V a, V b) { return _mm256_add_pd(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_pd(a, b); }
+    static V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+    static V div(V a, V b) { return _mm256_div_pd(a, b); }
+    static V min(V a, V b) { return _mm256_min_pd(a, b); }
+    static V max(V a, V b) { return _mm256_max_pd(a, b); }
+    static V neg(V a) { return _mm256_xor_pd(a, _mm256_set1_pd(-0.0)); }
+};
+
+// IEEE half storage, float arithmetic (F16C conversions)
+struct F16 : F32 {
+    using T = uint16_t;
+    static V load(const T* p) { return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))); }
+    static void store(T* p, V v)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+    }
+    static C to_c(T x) { return _cvtsh_ss(x); }
+    static T from_c(C x) { return static_cast<T>(_cvtss_sh(x, _MM_FROUND_TO_NEAREST_INT)); }
+};
+
+// bfloat16 storage, float arithmetic: widen by shifting, narrow with round to nearest even
+struct BF16 : F32 {
+    using T = uint16_t;
+    static V load(const T* p)
+    {
+        const __m256i wide = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+        return _mm256_castsi256_ps(_mm256_slli_epi32(wide, 16));
+    }
+    static void store(T* p, V v)
+    {
+        const __m256i x = _mm256_castps_si256(v);
+        const __m256i upper = _mm256_srli_epi32(x, 16);
+        const __m256i bias = _mm256_add_epi32(_mm256_set1_epi32(0x7FFF), _mm256_and_si256(upper, _mm256_set1_epi32(1)));
+        __m256i r = _mm256_srli_epi32(_mm256_add_epi32(x, bias), 16);
+        const __m256i quiet_nan = _mm256_or_si256(upper, _mm256_set1_epi32(0x40));
+        r = _mm256_blendv_epi8(r, quiet_nan, _mm256_castps_si256(_mm256_cmp_ps(v, v, _CMP_UNORD_Q)));
+        // Pack to 16 bits (within 128-bit lanes), then move the two useful quadwords together
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(r, r), 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm256_castsi256_si128(packed));
+    }
+    static C to_c(T x) { return _mm_cvtss_f32(_mm_castsi128_ps(_mm_cvtsi32_si128(static_cast<int>(x) << 16))); }
+    static T from_c(C x)
+    {
+        const uint32_t bits = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_castps_si128(_mm_set_ss(x))));
+        if ((bits & 0x7FFFFFFFu) > 0x7F800000u) return static_cast<T>((bits >> 16) | 0x40u);
+        return static_cast<T>((bits + 0x7FFFu + ((bits >> 16) & 1u)) >> 16);
+    }
+};
+
+} // namespace
+
+void integrate(float* values, float* deltas, float* delta_steps, const float* targets,
+               std::size_t n, float max_value, bool clear_delta_steps, float* norms)
+{
+    kernels::integrate<F32>(values, deltas, delta_steps, targets, n, max_value, clear_delta_steps, norms);
+}
+
+void integrate(double* values, double* deltas, double* delta_steps, const double* targets,
+               std::size_t n, double max_value, bool clear_delta_steps, double* norms)
+{
+    kernels::integrate<F64>(values, deltas, delta_steps, targets, n, max_value, clear_delta_steps, norms);
+}
+
+void gather_interior(float* out, const float* up, const float* mid, const float* down,
+                     std::size_t n, bool accumulate)
+{
+    kernels::gather_interior<F32>(out, up, mid, down, n, accumulate);
+}
+
+void gather_interior(double* out, const double* up, const double* mid, const double* down,
+                     std::size_t n, bool accumulate)
+{
+    kernels::gather_interior<F64>(out, up, mid, down, n, accumulate);
+}
+
+// 16-bit storage: the layout is a bare uint16_t, see units_half.h
+void integrate(units_half* values, units_half* deltas, units_half* delta_steps, const units_half* targets,
+               std::size_t n, float max_value, bool clear_delta_steps, float* norms)
+{
+    kernels::integrate<F16>(reinterpret_cast<uint16_t*>(values), reinterpret_cast<uint16_t*>(deltas),
+                            reinterpret_cast<uint16_t*>(delta_steps), reinterpret_cast<const uint16_t*>(targets),
+                            n, max_value, clear_delta_steps, norms);
+}
+
+void integrate(units_bfloat16* values, units_bfloat16* deltas, units_bfloat16* delta_steps,
+               const units_bfloat16* targets, std::size_t n, float max_value, bool clear_delta_steps,
+               float* norms)
+{
+    kernels::integrate<BF16>(reinterpret_cast<uint16_t*>(values), reinterpret_cast<uint16_t*>(deltas),
+                             reinterpret_cast<uint16_t*>(delta_steps), reinterpret_cast<const uint16_t*>(targets),
+                             n, max_value, clear_delta_steps, norms);
+}
+
+void gather_interior(units_half* out, const units_half* up, const units_half* mid, const units_half* down,
+                     std::size_t n, bool accumulate)
+{
+    kernels::gather_interior<F16>(reinterpret_cast<uint16_t*>(out), reinterpret_cast<const uint16_t*>(up),
+                                  reinterpret_cast<const uint16_t*>(mid), reinterpret_cast<const uint16_t*>(down),
+                                  n, accumulate);
+}
+
+void gather_interior(units_bfloat16* out, const units_bfloat16* up, const units_bfloat16* mid,
+                     const units_bfloat16* down, std::size_t n, bool accumulate)
+{
+    kernels::gather_interior<BF16>(reinterpret_cast<uint16_t*>(out), reinterpret_cast<const uint16_t*>(up),
+                                   reinterpret_cast<const uint16_t*>(mid), reinterpret_cast<const uint16_t*>(down),
+                                   n, accumulate);
+}
+
+void gather_sources(float* out, const float* deltas, const int* sources, const float* degrees, int count,
+                    std::size_t stride, std::size_t n)
+{
+    kernels::gather_sources<F32>(out, deltas, sources, degrees, count, stride, n);
+}
+
+void gather_sources(double* out, const double* deltas, const int* sources, const double* degrees, int count,
+                    std::size_t stride, std::size_t n)
+{
+    kernels::gather_sources<F64>(out, deltas, sources, degrees, count, stride, n);
+}
+
+void gather_sources(units_half* out, const units_half* deltas, const int* sources, const float* degrees,
+                    int count, std::size_t stride, std::size_t n)
+{
+    kernels::gather_sources<F16>(reinterpret_cast<uint16_t*>(out), reinterpret_cast<const uint16_t*>(deltas),
+                                 sources, degrees, count, stride, n);
+}
+
+void gather_sources(units_bfloat16* out, const units_bfloat16* deltas, const int* sources, const float* degrees,
+                    int count, std::size_t stride, std::size_t n)
+{
+    kernels::gather_sources<BF16>(reinterpret_cast<uint16_t*>(out), reinterpret_cast<const uint16_t*>(deltas),
+                                  sources, degrees, count, stride, n);
+}
+
+} // namespace avx2
+} // namespace units_simd
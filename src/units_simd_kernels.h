@@ -0,0 +1,142 @@
+#ifndef UNITS_SIMD_KERNELS_H
+#define UNITS_SIMD_KERNELS_H
+
+#include <cstddef>
+
+// Kernel bodies shared by the per-ISA translation units. Each TU is compiled with its own
+// -m flags and instantiates these templates with a vector traits type providing:
+//   T, C, V, lanes, load, store, spill, to_c, from_c, set1, zero, add, sub, mul, div, min, max, neg
+// T is the storage type and C the arithmetic type (float for 16-bit storage); load/store and
+// to_c/from_c convert between them, spill stores a vector of C unconverted.
+// Keep this header free of standard library includes so that no inline library code is
+// emitted with ISA-specific instructions (it could be picked by the linker for baseline code).
+
+namespace units_simd {
+namespace kernels {
+
+template <typename S>
+inline void integrate(typename S::T* values, typename S::T* deltas, typename S::T* delta_steps,
+                      const typename S::T* targets, std::size_t n, typename S::C max_value,
+                      bool clear_delta_steps, typename S::C* norms)
+{
+    using C = typename S::C;
+    const auto hi = S::set1(max_value);
+    const auto lo = S::set1(-max_value);
+    const auto zero = S::zero();
+    auto max_abs = zero;
+    auto sum_sq = zero;
+
+    std::size_t i = 0;
+    for (; i + S::lanes <= n; i += S::lanes) {
+        auto v = S::add(S::add(S::load(values + i), S::load(delta_steps + i)), S::load(deltas + i));
+        // min(hi, v) / max(lo, v) return v for NaN, like the scalar if/else chain
+        v = S::max(lo, S::min(hi, v));
+        S::store(values + i, v);
+        const auto d = S::sub(S::load(targets + i), v);
+        S::store(deltas + i, d);
+        if (clear_delta_steps) S::store(delta_steps + i, zero);
+        if (norms) {
+            max_abs = S::max(max_abs, S::max(d, S::neg(d)));
+            sum_sq = S::add(sum_sq, S::mul(d, d));
+        }
+    }
+
+    C norm_max = 0.0;
+    C norm_sq = 0.0;
+    if (norms && i > 0) {
+        C lanes_max[S::lanes];
+        C lanes_sq[S::lanes];
+        S::spill(lanes_max, max_abs);
+        S::spill(lanes_sq, sum_sq);
+        for (std::size_t k = 0; k < S::lanes; ++k) {
+            if (lanes_max[k] > norm_max) norm_max = lanes_max[k];
+            norm_sq += lanes_sq[k];
+        }
+    }
+    for (; i < n; ++i) {
+        C v = S::to_c(values[i]) + S::to_c(delta_steps[i]) + S::to_c(deltas[i]);
+        if (v > max_value) v = max_value;
+        else if (v < -max_value) v = -max_value;
+        values[i] = S::from_c(v);
+        const C d = S::to_c(targets[i]) - v;
+        deltas[i] = S::from_c(d);
+        if (clear_delta_steps) delta_steps[i] = S::from_c(0.0);
+        if (norms) {
+            const C a = d < 0 ? -d : d;
+            if (a > norm_max) norm_max = a;
+            norm_sq += d * d;
+        }
+    }
+    if (norms) {
+        if (norm_max > norms[0]) norms[0] = norm_max;
+        norms[1] += norm_sq;
+    }
+}
+
+template <typename S>
+inline void gather_interior(typename S::T* out, const typename S::T* up, const typename S::T* mid,
+                            const typename S::T* down, std::size_t n, bool accumulate)
+{
+    using C = typename S::C;
+    // -delta / 8 == -(delta * 0.125) exactly, since 8 is a power of two
+    const auto eighth = S::set1(static_cast<C>(0.125));
+
+    std::size_t x = 0;
+    for (; x + S::lanes <= n; x += S::lanes) {
+        auto sum = S::zero();
+        sum = S::add(sum, S::neg(S::mul(S::load(up + x - 1), eighth)));
+        sum = S::add(sum, S::neg(S::mul(S::load(up + x), eighth)));
+        sum = S::add(sum, S::neg(S::mul(S::load(up + x + 1), eighth)));
+        sum = S::add(sum, S::neg(S::mul(S::load(mid + x - 1), eighth)));
+        sum = S::add(sum, S::neg(S::mul(S::load(mid + x + 1), eighth)));
+        sum = S::add(sum, S::neg(S::mul(S::load(down + x - 1), eighth)));
+        sum = S::add(sum, S::neg(S::mul(S::load(down + x), eighth)));
+        sum = S::add(sum, S::neg(S::mul(S::load(down + x + 1), eighth)));
+        S::store(out + x, accumulate ? S::add(S::load(out + x), sum) : sum);
+    }
+    const C degree = 8;
+    for (std::ptrdiff_t i = static_cast<std::ptrdiff_t>(x); i < static_cast<std::ptrdiff_t>(n); ++i) {
+        C sum = 0.0;
+        sum += -S::to_c(up[i - 1]) / degree;
+        sum += -S::to_c(up[i]) / degree;
+        sum += -S::to_c(up[i + 1]) / degree;
+        sum += -S::to_c(mid[i - 1]) / degree;
+        sum += -S::to_c(mid[i + 1]) / degree;
+        sum += -S::to_c(down[i - 1]) / degree;
+        sum += -S::to_c(down[i]) / degree;
+        sum += -S::to_c(down[i + 1]) / degree;
+        out[i] = S::from_c(accumulate ? S::to_c(out[i]) + sum : sum);
+    }
+}
+
+template <typename S>
+inline void gather_sources(typename S::T* out, const typename S::T* deltas, const int* sources,
+                           const typename S::C* degrees, int count, std::size_t stride, std::size_t n)
+{
+    using C = typename S::C;
+    const auto eighth = S::set1(static_cast<C>(0.125));
+
+    std::size_t k = 0;
+    for (; k + S::lanes <= n; k += S::lanes) {
+        auto sum = S::zero();
+        for (int s = 0; s < count; ++s) {
+            const auto d = S::load(deltas + static_cast<std::size_t>(sources[s]) * stride + k);
+            // Division only for the clipped border degrees; /8 is an exact multiply
+            const auto c = degrees[s] == static_cast<C>(8) ? S::mul(d, eighth) : S::div(d, S::set1(degrees[s]));
+            sum = S::add(sum, S::neg(c));
+        }
+        S::store(out + k, sum);
+    }
+    for (; k < n; ++k) {
+        C sum = 0.0;
+        for (int s = 0; s < count; ++s) {
+            sum += -S::to_c(deltas[static_cast<std::size_t>(sources[s]) * stride + k]) / degrees[s];
+        }
+        out[k] = S::from_c(sum);
+    }
+}
+
+} // namespace kernels
+} // namespace units_simd
+
+#endif // UNITS_SIMD_KERNELS_H
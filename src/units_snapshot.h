@@ -0,0 +1,129 @@
+#ifndef UNITS_SNAPSHOT_H
+#define UNITS_SNAPSHOT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "units_buffer.h"
+
+// Lock-free publication of a per-cell array from one writer thread to any number of readers.
+//
+// Three slots: the latest published one, and two the writer can fill. publish() copies into a
+// slot that is neither the latest nor pinned by a reader, then makes it the latest with one
+// atomic store. A reader pins the latest slot by bumping its reader count and re-checking that
+// it is still the latest (otherwise it retries), and reads it in place until it pins another.
+// Neither side ever blocks: with one reader a free slot always exists; when several readers
+// pin both spare slots, publish() drops that frame instead of waiting.
+template <typename T>
+class UnitsSnapshotBuffer {
+public:
+    static constexpr int kSlots = 3;
+
+    UnitsSnapshotBuffer() = default;
+    // Copies get fresh, unpublished slots of the same size (never the original's readers)
+    UnitsSnapshotBuffer(const UnitsSnapshotBuffer& other) { resize(other.m_size); }
+    UnitsSnapshotBuffer& operator=(const UnitsSnapshotBuffer& other)
+    {
+        if (this != &other) resize(other.m_size);
+        return *this;
+    }
+
+    // Allocates kSlots slots of n elements (first-touched with the static partition) and
+    // forgets any published snapshot; 0 frees them. No reader may hold a pin across this.
+    void resize(std::size_t n)
+    {
+        for (int s = 0; s < kSlots; ++s) {
+            if (n > 0) units_first_touch(m_slots[s], n, T());
+            else units_vector<T>().swap(m_slots[s]);
+            m_steps[s] = 0;
+            m_readers[s].store(0, std::memory_order_relaxed);
+        }
+        m_size = n;
+        m_latest.store(-1, std::memory_order_release);
+    }
+    std::size_t size() const { return m_size; }
+
+    // Writer: copies data[0, size()) and publishes it as `step`. Returns false (nothing
+    // published) when every spare slot is pinned.
+    bool publish(const T* data, std::uint64_t step)
+    {
+        const int latest = m_latest.load(std::memory_order_relaxed); // only this thread stores it
+        for (int s = 0; s < kSlots; ++s) {
+            if (s == latest || m_readers[s].load() != 0) continue;
+            units_parallel_copy(data, m_slots[s].data(), m_size);
+            m_steps[s] = step;
+            m_latest.store(s);
+            return true;
+        }
+        return false;
+    }
+
+    // Reader: pins the latest slot and returns it, or -1 before the first publish()
+    int pin() const
+    {
+        for (;;) {
+            const int s = m_latest.load();
+            if (s < 0) return -1;
+            m_readers[s].fetch_add(1);
+            if (m_latest.load() == s) return s; // still the latest: the writer will not reuse it
+            m_readers[s].fetch_sub(1);
+        }
+    }
+    void unpin(int slot) const { m_readers[slot].fetch_sub(1, std::memory_order_release); }
+
+    const T* data(int slot) const { return m_slots[slot].data(); }
+    std::uint64_t step(int slot) const { return m_steps[slot]; }
+
+private:
+    units_vector<T> m_slots[kSlots];
+    std::uint64_t m_steps[kSlots] = {};
+    mutable std::atomic<int> m_readers[kSlots] = {};
+    std::atomic<int> m_latest{ -1 };
+    std::size_t m_size = 0;
+};
+
+// A reader's pin on one UnitsSnapshotBuffer: acquire() moves it to the latest snapshot, and
+// data() / step() stay valid and unchanged until the next acquire() or release(). Without a
+// pin (before the first successful acquire(), after a failed one or release()), valid() is
+// false, data() returns nullptr and step() 0. One reader per thread; it must not outlive the
+// buffer.
+template <typename T>
+class UnitsSnapshotReader {
+public:
+    explicit UnitsSnapshotReader(const UnitsSnapshotBuffer<T>& buffer) : m_buffer(&buffer) {}
+    ~UnitsSnapshotReader() { release(); }
+
+    UnitsSnapshotReader(UnitsSnapshotReader&& other) noexcept : m_buffer(other.m_buffer), m_slot(other.m_slot)
+    {
+        other.m_slot = -1;
+    }
+    UnitsSnapshotReader(const UnitsSnapshotReader&) = delete;
+    UnitsSnapshotReader& operator=(const UnitsSnapshotReader&) = delete;
+    UnitsSnapshotReader& operator=(UnitsSnapshotReader&&) = delete;
+
+    // Pins the latest snapshot (releasing the previous one); false if none is published yet
+    bool acquire()
+    {
+        const int slot = m_buffer->pin();
+        release();
+        m_slot = slot;
+        return slot >= 0;
+    }
+    void release()
+    {
+        if (m_slot >= 0) m_buffer->unpin(m_slot);
+        m_slot = -1;
+    }
+
+    bool valid() const { return m_slot >= 0; }
+    const T* data() const { return valid() ? m_buffer->data(m_slot) : nullptr; }
+    std::size_t size() const { return m_buffer->size(); }
+    std::uint64_t step() const { return valid() ? m_buffer->step(m_slot) : 0; }
+
+private:
+    const UnitsSnapshotBuffer<T>* m_buffer;
+    int m_slot = -1;
+};
+
+#endif // UNITS_SNAPSHOT_H
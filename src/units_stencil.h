@@ -0,0 +1,43 @@
+#ifndef UNITS_STENCIL_H
+#define UNITS_STENCIL_H
+
+// Moore-neighborhood wiring shared by UnitsCoreT and UnitsEnsembleT (internal header). Both
+// build their neighbor/source lists from these helpers, so the ensemble's wiring and
+// contribution degrees cannot drift from the core's, which its bit-identical guarantee needs.
+
+namespace units_stencil {
+
+// Visit the 8-neighbour stencil of (x, y) in the canonical order (dy, then dx, ascending),
+// calling visit(nx, ny, dy). Torus wiring wraps coordinates; otherwise out-of-range
+// neighbors are skipped.
+template <typename Visit>
+inline void for_each_moore_neighbor(int x, int y, int W, int H, bool torus, Visit&& visit)
+{
+    for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+            if (dx == 0 && dy == 0) continue;
+            int nx = x + dx;
+            int ny = y + dy;
+            if (torus) {
+                nx = (nx + W) % W;
+                ny = (ny + H) % H;
+            } else {
+                if (nx < 0 || nx >= W || ny < 0 || ny >= H) continue;
+            }
+            visit(nx, ny, dy);
+        }
+    }
+}
+
+// Number of neighbors of (x, y); always 8 on a torus
+inline int moore_degree(int x, int y, int W, int H, bool torus)
+{
+    if (torus) return 8;
+    const int cols = 1 + (x > 0 ? 1 : 0) + (x < W - 1 ? 1 : 0);
+    const int rows = 1 + (y > 0 ? 1 : 0) + (y < H - 1 ? 1 : 0);
+    return cols * rows - 1;
+}
+
+} // namespace units_stencil
+
+#endif // UNITS_STENCIL_H
@@ -0,0 +1,132 @@
+#include "units_thread_pool.h"
+#include "units_buffer.h"
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#include <immintrin.h>
+#define UNITS_CPU_RELAX() _mm_pause()
+#else
+#define UNITS_CPU_RELAX() ((void)0)
+#endif
+
+namespace {
+
+// Busy-wait iterations before a waiter yields its CPU (barrier) or goes to sleep (idle worker).
+// Short enough that an oversubscribed pool still makes progress.
+constexpr int kSpinIterations = 1 << 12;
+
+template <typename Done>
+inline void spin_until(Done&& done)
+{
+    for (int i = 0; !done(); ++i) {
+        if (i < kSpinIterations) UNITS_CPU_RELAX();
+        else std::this_thread::yield();
+    }
+}
+
+} // namespace
+
+UnitsThreadPool::UnitsThreadPool(int threads, bool pin)
+    : m_threads(threads),
+      m_pinned(false),
+      m_starting(0),
+      m_pin_failures(0),
+      m_invoke(nullptr),
+      m_job(nullptr),
+      m_job_generation(0),
+      m_pending(0),
+      m_sleepers(0),
+      m_stop(false),
+      m_arrived(0),
+      m_phase(0)
+{
+    if (threads <= 0) throw std::invalid_argument("thread pool size must be > 0");
+
+    if (pin) m_cpus = units_allowed_cpus();
+    m_starting.store(threads - 1, std::memory_order_relaxed);
+    m_workers.reserve(static_cast<std::size_t>(threads - 1));
+    for (int tid = 1; tid < threads; ++tid) {
+        m_workers.emplace_back(&UnitsThreadPool::worker, this, tid);
+    }
+    // Workers pin themselves first thing; wait for them so that pinned() is final
+    spin_until([this] { return m_starting.load(std::memory_order_acquire) == 0; });
+    m_pinned = pin && !m_cpus.empty() && m_pin_failures.load(std::memory_order_relaxed) == 0;
+}
+
+UnitsThreadPool::~UnitsThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop.store(true, std::memory_order_relaxed);
+        m_job_generation.fetch_add(1, std::memory_order_release);
+    }
+    m_wake.notify_all();
+    for (std::thread& t : m_workers) t.join();
+}
+
+void UnitsThreadPool::run(Invoke invoke, void* job)
+{
+    if (m_threads == 1) {
+        invoke(job, 0, 1);
+        return;
+    }
+
+    m_invoke = invoke;
+    m_job = job;
+    m_pending.store(m_threads - 1, std::memory_order_relaxed);
+    // Spinning workers see the generation move; parked ones also need the notification. Both
+    // the bump and the sleeper check are seq_cst, pairing with the worker's increment of
+    // m_sleepers before its last check, so a worker about to park is never missed.
+    m_job_generation.fetch_add(1, std::memory_order_seq_cst);
+    if (m_sleepers.load(std::memory_order_seq_cst) > 0) {
+        { std::lock_guard<std::mutex> lock(m_mutex); }
+        m_wake.notify_all();
+    }
+
+    invoke(job, 0, m_threads);
+
+    spin_until([this] { return m_pending.load(std::memory_order_acquire) == 0; });
+    m_invoke = nullptr;
+    m_job = nullptr;
+}
+
+void UnitsThreadPool::barrier()
+{
+    if (m_threads == 1) return;
+
+    const std::uint32_t phase = m_phase.load(std::memory_order_relaxed);
+    if (m_arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == m_threads) {
+        // Last arrival: reset the count before releasing the others into the next phase
+        m_arrived.store(0, std::memory_order_relaxed);
+        m_phase.store(phase + 1, std::memory_order_release);
+        return;
+    }
+    spin_until([this, phase] { return m_phase.load(std::memory_order_acquire) != phase; });
+}
+
+void UnitsThreadPool::worker(int tid)
+{
+    if (!m_cpus.empty() && !units_pin_current_thread(m_cpus, tid)) {
+        m_pin_failures.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_starting.fetch_sub(1, std::memory_order_release);
+
+    std::uint64_t seen = 0;
+    for (;;) {
+        // Spin for a back-to-back job (the common case while stepping), then sleep
+        for (int i = 0; i < kSpinIterations && m_job_generation.load(std::memory_order_acquire) == seen; ++i) {
+            UNITS_CPU_RELAX();
+        }
+        if (m_job_generation.load(std::memory_order_acquire) == seen) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+            m_wake.wait(lock, [this, seen] { return m_job_generation.load(std::memory_order_seq_cst) != seen; });
+            m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+        }
+        seen = m_job_generation.load(std::memory_order_acquire);
+        if (m_stop.load(std::memory_order_relaxed)) return;
+
+        m_invoke(m_job, tid, m_threads);
+        m_pending.fetch_sub(1, std::memory_order_release);
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef UNITS_THREAD_POOL_H
+#define UNITS_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Persistent worker threads for UnitsCoreT's pooled stepping (set_thread_pool()).
+// OpenMP opens a parallel region per phase; at 256x256 the fork/join and barrier cost of
+// those regions exceeds the work. Here the workers are created once (optionally pinned to a
+// CPU each), run() hands them one job that spans a whole step or many steps, and the phases
+// inside the job are separated by barrier(), a sense-reversing spin barrier on one atomic.
+// Idle workers spin briefly for the next job and then sleep on a condition variable.
+//
+// One thread at a time drives a pool: run() must not be called concurrently on the same pool
+// (nothing guards against it), though cores stepped one after another can share it.
+class UnitsThreadPool {
+public:
+    // threads counts the calling thread, which runs as thread 0 inside run(). With pin, worker
+    // t is pinned to the t-th CPU of the process's affinity mask (units_pin_current_thread());
+    // the calling thread keeps its own affinity.
+    explicit UnitsThreadPool(int threads, bool pin = true);
+    ~UnitsThreadPool();
+
+    UnitsThreadPool(const UnitsThreadPool&) = delete;
+    UnitsThreadPool& operator=(const UnitsThreadPool&) = delete;
+
+    int size() const { return m_threads; }
+    // True if pinning was requested and every worker was pinned
+    bool pinned() const { return m_pinned; }
+
+    // Runs job(tid, size()) on every thread and returns when all have finished. The job is
+    // passed by reference (no std::function), so dispatching never allocates.
+    template <typename Job>
+    void run(Job&& job)
+    {
+        using Callable = typename std::remove_reference<Job>::type;
+        run(&invoke<Callable>, const_cast<void*>(static_cast<const void*>(&job)));
+    }
+
+    // Blocks until all size() threads of the current run() have reached it
+    void barrier();
+
+private:
+    using Invoke = void (*)(void* job, int tid, int threads);
+
+    template <typename Callable>
+    static void invoke(void* job, int tid, int threads) { (*static_cast<Callable*>(job))(tid, threads); }
+
+    void run(Invoke invoke, void* job);
+    void worker(int tid);
+
+    int m_threads;
+    bool m_pinned;
+    std::vector<int> m_cpus; // CPUs the workers pin to (empty: no pinning)
+    std::atomic<int> m_starting; // workers not yet past their pinning
+    std::atomic<int> m_pin_failures;
+    std::vector<std::thread> m_workers;
+    Invoke m_invoke;
+    void* m_job;
+
+    // Job hand-off: workers wait for m_job_generation to move (spin, then sleep). run() only
+    // takes the mutex and notifies when m_sleepers says a worker has parked.
+    alignas(64) std::atomic<std::uint64_t> m_job_generation;
+    alignas(64) std::atomic<int> m_pending; // workers still running the current job
+    alignas(64) std::atomic<int> m_sleepers; // workers parked on m_wake
+    std::atomic<bool> m_stop;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+
+    // Spin barrier state: arrivals in the current phase, and the phase counter waiters watch
+    alignas(64) std::atomic<int> m_arrived;
+    alignas(64) std::atomic<std::uint32_t> m_phase;
+};
+
+#endif // UNITS_THREAD_POOL_H
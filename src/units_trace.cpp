@@ -0,0 +1,149 @@
+#include "units_trace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    std::uint64_t begin; // ns, steady clock
+    std::uint64_t end;
+};
+
+// One writer (the owning thread) per ring; `written` only grows, the slot is written % capacity
+struct alignas(64) TraceRing {
+    TraceEvent* events = nullptr;
+    std::atomic<std::uint64_t> written{ 0 };
+};
+
+std::atomic<bool> g_enabled{ false };
+std::atomic<unsigned> g_generation{ 0 }; // bumped by units_trace_start(): threads take new slots
+std::atomic<int> g_next_slot{ 0 };
+std::atomic<std::uint64_t> g_dropped{ 0 };
+std::unique_ptr<TraceEvent[]> g_events;
+std::unique_ptr<TraceRing[]> g_rings;
+std::size_t g_capacity = 0;
+int g_max_threads = 0;
+std::uint64_t g_origin = 0;
+std::string g_exit_path;
+bool g_exit_registered = false;
+
+inline std::uint64_t now_ns()
+{
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void record(const char* name, std::uint64_t begin, std::uint64_t end)
+{
+    thread_local int slot = -1;
+    thread_local unsigned generation = ~0u;
+    const unsigned current = g_generation.load(std::memory_order_acquire);
+    if (generation != current) {
+        generation = current;
+        slot = g_next_slot.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (slot >= g_max_threads) {
+        g_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    TraceRing& ring = g_rings[slot];
+    const std::uint64_t n = ring.written.load(std::memory_order_relaxed);
+    ring.events[n % g_capacity] = TraceEvent{ name, begin, end };
+    ring.written.store(n + 1, std::memory_order_release);
+}
+
+void write_at_exit()
+{
+    if (!g_exit_path.empty()) units_trace_write(g_exit_path.c_str());
+}
+
+} // namespace
+
+void units_trace_start(const char* path, std::size_t events_per_thread, int max_threads)
+{
+    // Not meant to race with recording threads: start before stepping
+    g_enabled.store(false, std::memory_order_relaxed);
+    if (max_threads <= 0) max_threads = std::max(64, 2 * static_cast<int>(std::thread::hardware_concurrency()));
+    events_per_thread = std::max<std::size_t>(events_per_thread, 1);
+
+    g_capacity = events_per_thread;
+    g_max_threads = max_threads;
+    g_events.reset(new TraceEvent[static_cast<std::size_t>(max_threads) * events_per_thread]);
+    g_rings.reset(new TraceRing[static_cast<std::size_t>(max_threads)]);
+    for (int t = 0; t < max_threads; ++t) {
+        g_rings[t].events = &g_events[static_cast<std::size_t>(t) * events_per_thread];
+    }
+    g_next_slot.store(0, std::memory_order_relaxed);
+    g_dropped.store(0, std::memory_order_relaxed);
+    g_origin = now_ns();
+
+    g_exit_path = path ? path : "";
+    if (path && !g_exit_registered) {
+        std::atexit(write_at_exit);
+        g_exit_registered = true;
+    }
+    g_generation.fetch_add(1, std::memory_order_release);
+    g_enabled.store(true, std::memory_order_release);
+}
+
+void units_trace_stop()
+{
+    g_enabled.store(false, std::memory_order_release);
+}
+
+bool units_trace_enabled()
+{
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+std::uint64_t units_trace_dropped()
+{
+    return g_dropped.load(std::memory_order_relaxed);
+}
+
+bool units_trace_write(const char* path)
+{
+    std::FILE* f = std::fopen(path, "w");
+    if (!f) return false;
+
+    std::fprintf(f, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+    bool first = true;
+    const int threads = std::min(g_next_slot.load(std::memory_order_acquire), g_max_threads);
+    for (int t = 0; t < threads; ++t) {
+        const TraceRing& ring = g_rings[t];
+        std::fprintf(f, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+                        "\"args\": {\"name\": \"thread %d\"}}", first ? "" : ",\n", t, t);
+        first = false;
+
+        // The ring holds the last `capacity` events, oldest at written % capacity
+        const std::uint64_t written = ring.written.load(std::memory_order_acquire);
+        const std::uint64_t count = std::min<std::uint64_t>(written, g_capacity);
+        for (std::uint64_t i = written - count; i < written; ++i) {
+            const TraceEvent& e = ring.events[i % g_capacity];
+            if (e.begin < g_origin) continue; // recorded before this trace started
+            std::fprintf(f, ",\n{\"name\": \"%s\", \"cat\": \"units\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, "
+                            "\"ts\": %.3f, \"dur\": %.3f}",
+                         e.name, t, (e.begin - g_origin) * 1e-3, (e.end - e.begin) * 1e-3);
+        }
+    }
+    std::fprintf(f, "\n]}\n");
+    return std::fclose(f) == 0;
+}
+
+UnitsTraceScope::UnitsTraceScope(const char* name)
+    : m_name(name),
+      m_begin(g_enabled.load(std::memory_order_relaxed) ? now_ns() : 0)
+{
+}
+
+UnitsTraceScope::~UnitsTraceScope()
+{
+    if (m_begin != 0 && g_enabled.load(std::memory_order_relaxed)) record(m_name, m_begin, now_ns());
+}
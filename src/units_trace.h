@@ -0,0 +1,55 @@
+#ifndef UNITS_TRACE_H
+#define UNITS_TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Timeline tracing of the per-thread step phases (USE_TRACE builds).
+//
+// Every thread that records gets its own preallocated ring of complete events (phase name,
+// begin, end), so recording is a couple of clock reads and stores with no locks and no
+// allocation; when a ring is full the oldest events are overwritten, so the most recent steps
+// are kept. units_trace_write() dumps all rings as Chrome trace-event JSON (open it in
+// Perfetto or chrome://tracing): one track per thread, with barrier waits and stragglers
+// showing up as gaps between a thread's phases.
+//
+// UNITS_TRACE_SCOPE(name) records the enclosing scope under `name` (a string literal) when
+// built with USE_TRACE and tracing has been started; otherwise it compiles to nothing.
+
+// Starts recording with rings of events_per_thread events for up to max_threads threads
+// (0 = twice the hardware threads, at least 64). With a non-null path, the trace is written
+// there when the process exits. Calling it again restarts the trace.
+void units_trace_start(const char* path = nullptr, std::size_t events_per_thread = std::size_t(1) << 14,
+                       int max_threads = 0);
+void units_trace_stop();
+bool units_trace_enabled();
+
+// Writes the recorded events as Chrome trace-event JSON; false if the file cannot be written
+bool units_trace_write(const char* path);
+
+// Events dropped because more than max_threads threads recorded
+std::uint64_t units_trace_dropped();
+
+// Records [construction, destruction) of the scope on the calling thread's ring
+class UnitsTraceScope {
+public:
+    explicit UnitsTraceScope(const char* name);
+    ~UnitsTraceScope();
+
+    UnitsTraceScope(const UnitsTraceScope&) = delete;
+    UnitsTraceScope& operator=(const UnitsTraceScope&) = delete;
+
+private:
+    const char* m_name;
+    std::uint64_t m_begin; // 0 when tracing is off
+};
+
+#if defined(USE_TRACE)
+#define UNITS_TRACE_CONCAT_(a, b) a##b
+#define UNITS_TRACE_CONCAT(a, b) UNITS_TRACE_CONCAT_(a, b)
+#define UNITS_TRACE_SCOPE(name) UnitsTraceScope UNITS_TRACE_CONCAT(units_trace_scope_, __LINE__)(name)
+#else
+#define UNITS_TRACE_SCOPE(name) ((void)0)
+#endif
+
+#endif // UNITS_TRACE_H